@@ -1,17 +1,35 @@
 #include "Actor.h"
 #include "StudentWorld.h"
+#include "Snapshot.h"
+#include <climits>
 
 // ACTOR ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Actor::Actor(StudentWorld* world, int imageID, double startX, double startY, int startDirection, int depth)
-: GraphObject(imageID, startX, startY, startDirection, depth)
+: GraphObject(&world->components(), world->components().acquire(this), imageID, startX, startY, startDirection, depth)
 {
-    this->status = true;
-    this->m_world = world;
 }
 
-Actor::~Actor() {}
+Actor::~Actor()
+{
+    components().release(getHandle());
+}
+
+void* Actor::operator new(std::size_t size, StudentWorld* world)
+{
+    return world->actorPool().allocate(size);
+}
+
+void Actor::operator delete(void* p, StudentWorld* /* world */)
+{
+    ActorPool::deallocate(p);
+}
+
+void Actor::operator delete(void* p)
+{
+    ActorPool::deallocate(p);
+}
 
-bool Actor::isAlive() const { return this->status; }
+bool Actor::isAlive() const { return components().isAlive(getHandle()); }
 
 bool Actor::blocks() const { return false; }
 
@@ -24,12 +42,12 @@ void Actor::takeDamage(int damage)
 void Actor::die()
 {
     playDeathSound();
-    this->status = false;
+    components().setAlive(getHandle(), false);
 }
 
 bool Actor::move() { return false; }
 
-StudentWorld* Actor::world() const { return this->m_world; }
+StudentWorld* Actor::world() const { return components().world(); }
 
 bool Actor::isEdible() const { return false; }
 
@@ -39,6 +57,45 @@ bool Actor::isGoodie() const { return false; }
 
 bool Actor::preventsLevelCompletion() const { return false; }
 
+void Actor::moveTo(double x, double y)
+{
+    GraphObject::moveTo(x, y);
+    world()->actorMoved(this);
+}
+
+int Actor::getID() const { return components().id(getHandle()); }
+
+void Actor::setID(int id) { components().setID(getHandle(), id); }
+
+int Actor::getGridCell() const { return components().gridCell(getHandle()); }
+
+void Actor::setGridCell(int cell) { components().setGridCell(getHandle(), cell); }
+
+int Actor::getGridSlot() const { return components().gridSlot(getHandle()); }
+
+void Actor::setGridSlot(int slot) { components().setGridSlot(getHandle(), slot); }
+
+ActorComponents::Handle Actor::getHandle() const { return slot(); }
+
+ActorComponents& Actor::components() const { return *static_cast<ActorComponents*>(store()); }
+
+int Actor::randInt(int min, int max)
+{
+    // The draw counter starts over every tick, so what an actor rolls depends only
+    // on the world's seed, the actor's ID, the tick and how many times it has
+    // already rolled this tick -- not on which actors were updated before it.
+    ActorComponents& c = components();
+    long tick = world()->getTick();
+    std::uint32_t draws = (c.randomTick(getHandle()) == tick) ? c.randomDraws(getHandle()) : 0;
+    int result = CounterRandom::randInt(world()->getSeed(), getID(), tick, draws, min, max);
+    c.setRandomPosition(getHandle(), tick, draws);
+    return result;
+}
+
+void Actor::writeState(SnapshotWriter& /* out */) const {}
+
+void Actor::readState(SnapshotReader& /* in */) {}
+
 void Actor::playDeathSound() const {}
 
 // DIRT ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -53,6 +110,8 @@ Dirt::~Dirt()
     // ACTUALLY: Deleting the Dirt object is done by the StudentWorld class.
 }
 
+ActorType Dirt::getType() const { return ActorType::dirt; }
+
 void Dirt::doSomething()
 {
     // Dirt does nothing.
@@ -69,6 +128,8 @@ Pit::Pit(StudentWorld* world, double startX, double startY)
 
 Pit::~Pit() {}
 
+ActorType Pit::getType() const { return ActorType::pit; }
+
 void Pit::doSomething()
 {
     if (randInt(1, 50) == 1)
@@ -80,9 +141,9 @@ void Pit::doSomething()
             int index = randInt(0,2);
             if (bacteriaArr[index] != 0)
             {
-                     if (index == 0) world()->addActor(new RegularSalmonella(world(), getX(), getY()));
-                else if (index == 1) world()->addActor(new AggressiveSalmonella(world(), getX(), getY()));
-                else if (index == 2) world()->addActor(new EColi(world(), getX(), getY()));
+                     if (index == 0) world()->addActor(new (world()) RegularSalmonella(world(), getX(), getY()));
+                else if (index == 1) world()->addActor(new (world()) AggressiveSalmonella(world(), getX(), getY()));
+                else if (index == 2) world()->addActor(new (world()) EColi(world(), getX(), getY()));
                 bacteriaArr[index] -= 1;
                 spawned = true;
             }
@@ -99,6 +160,20 @@ bool Pit::preventsLevelCompletion() const
     return true;
 }
 
+void Pit::writeState(SnapshotWriter& out) const
+{
+    Actor::writeState(out);
+    for (int i = 0; i < 3; i++)
+        out.writeInt(bacteriaArr[i]);
+}
+
+void Pit::readState(SnapshotReader& in)
+{
+    Actor::readState(in);
+    for (int i = 0; i < 3; i++)
+        bacteriaArr[i] = in.readInt(0, INT_MAX);
+}
+
 bool Pit::pitEmpty() const
 {
     bool empty = true;
@@ -114,26 +189,38 @@ bool Pit::pitEmpty() const
 HealthyActor::HealthyActor(int hp, StudentWorld* world, int imageID, double startX, double startY, int startDirection, int depth)
 : Actor(world, imageID, startX, startY, startDirection, depth)
 {
-    this->hp = hp;
+    setHP(hp);
 }
 
 HealthyActor::~HealthyActor() {}
 
-void HealthyActor::incHP(int inc) { this->hp += inc; }
+void HealthyActor::incHP(int inc) { setHP(getHP() + inc); }
 
 void HealthyActor::decHP(int dec)
 {
-    this->hp -= dec;
-    if (this->hp <= 0 )
+    setHP(getHP() - dec);
+    if (getHP() <= 0 )
         die();
     
     if (isAlive())
         world()->playSound(SOUND_PLAYER_HURT);
 }
 
-int HealthyActor::getHP() const { return this->hp; }
+int HealthyActor::getHP() const { return components().hp(getHandle()); }
+
+void HealthyActor::setHP(int hp) { components().setHP(getHandle(), hp); }
 
-void HealthyActor::setHP(int hp) { this->hp = hp; }
+void HealthyActor::writeState(SnapshotWriter& out) const
+{
+    Actor::writeState(out);
+    out.writeInt(getHP());
+}
+
+void HealthyActor::readState(SnapshotReader& in)
+{
+    Actor::readState(in);
+    setHP(in.readInt());
+}
 
 // SOCRATES ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Socrates::Socrates(StudentWorld* world, int startX, int startY)
@@ -145,6 +232,8 @@ Socrates::Socrates(StudentWorld* world, int startX, int startY)
 
 Socrates::~Socrates() {}
 
+ActorType Socrates::getType() const { return ActorType::socrates; }
+
 void Socrates::doSomething()
 {
     int key = 0;
@@ -173,7 +262,7 @@ void Socrates::doSomething()
                     world()->playSound(SOUND_PLAYER_SPRAY);
                     double dx = 0, dy = 0;
                     getPositionInThisDirection(getDirection(), 0, dx, dy);
-                    DisinfectantSpray* spray = new DisinfectantSpray(world(), dx, dy, getDirection());
+                    DisinfectantSpray* spray = new (world()) DisinfectantSpray(world(), dx, dy, getDirection());
                     world()->addActor(spray);
                     --sprayCharges;
                 }
@@ -186,7 +275,7 @@ void Socrates::doSomething()
                     for (int i = 0; i < 16; i++)
                     {
                         getPositionInThisDirection(22*i, 0, dx, dy);
-                        Flame* flame = new Flame(world(), dx, dy, 22*i);
+                        Flame* flame = new (world()) Flame(world(), dx, dy, 22*i);
                         world()->addActor(flame);  
                     }
                     --flameCharges;
@@ -227,6 +316,20 @@ int Socrates::getFlameCharges() const { return flameCharges; }
 
 int Socrates::getSprayCharges() const { return sprayCharges; }
 
+void Socrates::writeState(SnapshotWriter& out) const
+{
+    HealthyActor::writeState(out);
+    out.writeInt(sprayCharges);
+    out.writeInt(flameCharges);
+}
+
+void Socrates::readState(SnapshotReader& in)
+{
+    HealthyActor::readState(in);
+    sprayCharges = in.readInt();
+    flameCharges = in.readInt();
+}
+
 void Socrates::move(const int KEY_PRESS)
 {
 
@@ -234,7 +337,9 @@ void Socrates::move(const int KEY_PRESS)
     double x = getX()/VIEW_RADIUS - 1;
     double y = getY()/VIEW_RADIUS - 1;
     double angle = 0;
-    const double PI = 4 * atan(1);
+    // Socrates' place on the rim isn't a whole number of degrees, so this
+    // stays on libm; only the constant comes from Trig.
+    const double PI = Trig::PI;
     const double fiveD = ( KEY_PRESS == KEY_PRESS_LEFT) ? 5*PI/180 : -5*PI/180;
     
     // atan returns values (-180, 180), so we gotta catch the case when its Socrates is in 2nd, 3rd quadrants
@@ -258,9 +363,8 @@ void Socrates::playDeathSound() const
 Bacterium::Bacterium(int nFood, int movementDistancePlan, int hp, StudentWorld* world, int imageID, double startX, double startY)
 : HealthyActor(hp, world, imageID, startX, startY, 90, 0)
 {
-    this->nFood = nFood;
-    this->movementDistancePlan = movementDistancePlan;
-    this->overlapsWithSocrates = false;
+    setFood(nFood);
+    setMovementDistancePlan(movementDistancePlan);
 }
 
 Bacterium::~Bacterium() {}
@@ -270,7 +374,7 @@ void Bacterium::die()
     Actor::die();
     
     if (randInt(1, 2) == 1)
-        world()->addActor(new Food(world(), getX(), getY()));
+        world()->addActor(new (world()) Food(world(), getX(), getY()));
 }
 
 bool Bacterium::tryMove()
@@ -280,11 +384,21 @@ bool Bacterium::tryMove()
     Socrates* socrates = world()->getOverlappingSocrates(this);
     if (isOverlappingWithSocrates())
     {
-        socrates->takeDamage(getDamage());
+        if (world()->isDeferringEffects())
+            intent.hitsSocrates = true;
+        else
+            socrates->takeDamage(getDamage());
     }
     else if (canMultiply(newX, newY))
     {
-        addBacterium(newX, newY);  //change this to addBacterium(newX, newY)
+        if (world()->isDeferringEffects())
+        {
+            intent.multiplies = true;
+            intent.newX = newX;
+            intent.newY = newY;
+        }
+        else
+            addBacterium(newX, newY);  //change this to addBacterium(newX, newY)
     }
     else if (edible != nullptr)
         eat(edible);
@@ -298,7 +412,7 @@ bool Bacterium::preventsLevelCompletion() const { return true; }
 
 bool Bacterium::canMultiply(double &newX, double &newY)
 {
-    if (nFood == 3)
+    if (getFood() == 3)
     {
         double changeX = (getX() < VIEW_WIDTH/2) ? SPRITE_WIDTH/2 : -SPRITE_WIDTH/2;
         double changeY = (getY() < VIEW_HEIGHT/2) ? SPRITE_WIDTH/2 : -SPRITE_WIDTH/2;
@@ -306,7 +420,7 @@ bool Bacterium::canMultiply(double &newX, double &newY)
         if (getX() != VIEW_WIDTH/2) newX = getX() + changeX;
         if (getY() != VIEW_HEIGHT/2) newY = getY() + changeY;
         
-        nFood = 0;
+        setFood(0);
         
         return true;
     }
@@ -316,29 +430,57 @@ bool Bacterium::canMultiply(double &newX, double &newY)
 
 void Bacterium::eat(Actor* edible)
 {
-    if (edible != nullptr)
+    if (edible != nullptr && world()->isDeferringEffects())
+        intent.food = edible->getHandle();
+    else if (edible != nullptr)
     {
         setFood(getFood()+1);
         edible->die();
     }
 }
 
-int Bacterium::getFood() const { return nFood; }
+void Bacterium::commitIntent()
+{
+    // Moves weren't re-bucketed while the bacteria ran in parallel.
+    world()->actorMoved(this);
+    
+    if (intent.hitsSocrates)
+        world()->getSocrates()->takeDamage(getDamage());
+    if (intent.multiplies)
+        addBacterium(intent.newX, intent.newY);
+    // Bacteria commit in update order, so the first one to reach a food gets
+    // it. Nothing is swept away mid-tick, so the handle still names it.
+    if (intent.food >= 0 && components().isAlive(intent.food))
+        eat(components().actor(components().ref(intent.food)));
+    
+    intent = Intent();
+}
+
+int Bacterium::getFood() const { return components().food(getHandle()); }
+
+int Bacterium::getMovementDistancePlan() const { return components().movementPlan(getHandle()); }
+
+void Bacterium::setFood(int num) { components().setFood(getHandle(), num); }
 
-int Bacterium::getMovementDistancePlan() const { return this->movementDistancePlan; }
+void Bacterium::setMovementDistancePlan(int num) { components().setMovementPlan(getHandle(), num); }
 
-void Bacterium::setFood(int num) { this->nFood = num; }
+void Bacterium::writeState(SnapshotWriter& out) const
+{
+    HealthyActor::writeState(out);
+    out.writeInt(getFood());
+    out.writeInt(getMovementDistancePlan());
+}
 
-void Bacterium::setMovementDistancePlan(int num) { this->movementDistancePlan = num; }
+void Bacterium::readState(SnapshotReader& in)
+{
+    HealthyActor::readState(in);
+    setFood(in.readInt());
+    setMovementDistancePlan(in.readInt());
+}
 
 bool Bacterium::isOverlappingWithSocrates()
 {
-    Socrates* socrates = world()->getOverlappingSocrates(this);
-    if (socrates != nullptr)
-        overlapsWithSocrates = true;
-    else
-        overlapsWithSocrates = false;
-    return overlapsWithSocrates;
+    return world()->getOverlappingSocrates(this) != nullptr;
 }
 
 // SALMONELLA ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -361,7 +503,7 @@ bool Salmonella::tryMove()
     
     if (!moved && !isOverlappingWithSocrates())
     {
-        if (world()->getAngleToNearestNearbyEdible(this, VIEW_RADIUS, angle))
+        if (world()->getAngleToNearestNearbyEdible(this, VIEW_RADIUS, angle, foodTarget))
         {
             setDirection(angle);
             moved = move();
@@ -423,6 +565,8 @@ RegularSalmonella::RegularSalmonella(StudentWorld* world, double startX, double
 
 RegularSalmonella::~RegularSalmonella() {}
 
+ActorType RegularSalmonella::getType() const { return ActorType::regularSalmonella; }
+
 void RegularSalmonella::doSomething()
 {
     if (!isAlive()) return;
@@ -432,7 +576,7 @@ void RegularSalmonella::doSomething()
 
 void RegularSalmonella::addBacterium(double newX, double newY) const
 {
-    world()->addActor(new RegularSalmonella(world(), newX, newY));
+    world()->addActor(new (world()) RegularSalmonella(world(), newX, newY));
 }
 
 int RegularSalmonella::getDamage() const { return 1; }
@@ -444,12 +588,15 @@ AggressiveSalmonella::AggressiveSalmonella(StudentWorld* world, double startX, d
 
 AggressiveSalmonella::~AggressiveSalmonella() {}
 
+ActorType AggressiveSalmonella::getType() const { return ActorType::aggressiveSalmonella; }
+
 void AggressiveSalmonella::doSomething()
 {
     if (!isAlive()) return;
     
     int angle = 0;
-    bool seesSocrates = world()->getAngleToNearbySocrates(this, 72, angle);
+    bool routed = false;
+    bool seesSocrates = world()->getPursuitAngleToSocrates(this, 72, angle, routed);
     bool moved = false;
     
     if (seesSocrates && !isOverlappingWithSocrates())
@@ -465,7 +612,7 @@ void AggressiveSalmonella::doSomething()
 
 void AggressiveSalmonella::addBacterium(double newX, double newY) const
 {
-    world()->addActor(new AggressiveSalmonella(world(), newX, newY));
+    world()->addActor(new (world()) AggressiveSalmonella(world(), newX, newY));
 }
 
 int AggressiveSalmonella::getDamage() const { return 2; }
@@ -477,6 +624,8 @@ EColi::EColi(StudentWorld* world, double startX, double startY)
 
 EColi::~EColi() {}
 
+ActorType EColi::getType() const { return ActorType::eColi; }
+
 void EColi::takeDamage(int damage)
 {
     decHP(damage);
@@ -495,20 +644,34 @@ void EColi::doSomething()
     
     Bacterium::tryMove();
     
-    seesSocrates = world()->getAngleToNearbySocrates(this, 256, angle);
+    bool routed = false;
+    seesSocrates = world()->getPursuitAngleToSocrates(this, 256, angle, routed);
     
     if (seesSocrates)
     {
         setDirection(angle);
-        move();
+        // The field has already steered around the dirt, so its heading gets
+        // a single check. Turning to feel the way round is only for a
+        // straight-line heading, or a routed one that clips dirt right next
+        // to us (the field only knows cell centres); then it carries on
+        // turning where that first try left off.
+        if (!routed)
+            move();
+        else if (!moveTurning(1))
+            moveTurning(9);
     }
 }
 
 bool EColi::move()
+{
+    return moveTurning(10);
+}
+
+bool EColi::moveTurning(int attempts)
 {
     double dx = 0, dy = 0;
     bool blocked = false;
-    for (int i = 0; i < 10; i++)
+    for (int i = 0; i < attempts; i++)
     {
         getPositionInThisDirection(getDirection(), 2, dx, dy);
         blocked = world()->isBacteriumMovementBlockedAt(dx, dy);
@@ -528,7 +691,7 @@ int EColi::getDamage() const { return 4; }
 
 void EColi::addBacterium(double newX, double newY) const
 {
-    world()->addActor(new EColi(world(), newX, newY));
+    world()->addActor(new (world()) EColi(world(), newX, newY));
 }
 
 void EColi::playDeathSound() const
@@ -545,6 +708,8 @@ Food::Food(StudentWorld* world, int startX, int startY)
 
 Food::~Food() {}
 
+ActorType Food::getType() const { return ActorType::food; }
+
 void Food::doSomething()
 {
     // Food does nothing.
@@ -580,6 +745,18 @@ void Goodie::doSomething()
 
 int Goodie::getRemainingTicks() const { return this->remainingTicks; }
 
+void Goodie::writeState(SnapshotWriter& out) const
+{
+    Actor::writeState(out);
+    out.writeInt(remainingTicks);
+}
+
+void Goodie::readState(SnapshotReader& in)
+{
+    Actor::readState(in);
+    remainingTicks = in.readInt();
+}
+
 bool Goodie::isDamageable() const { return true; }
 
 bool Goodie::isGoodie() const { return true; }
@@ -592,6 +769,8 @@ RestoreHealthGoodie::RestoreHealthGoodie(int remainingTicks, StudentWorld* world
 
 RestoreHealthGoodie::~RestoreHealthGoodie() {}
 
+ActorType RestoreHealthGoodie::getType() const { return ActorType::restoreHealthGoodie; }
+
 void RestoreHealthGoodie::pickUp(Socrates* socrates)
 {
     // user get 250 points
@@ -606,6 +785,8 @@ FlamethrowerGoodie::FlamethrowerGoodie(int remainingTicks, StudentWorld* world,
 
 FlamethrowerGoodie::~FlamethrowerGoodie() {}
 
+ActorType FlamethrowerGoodie::getType() const { return ActorType::flamethrowerGoodie; }
+
 void FlamethrowerGoodie::pickUp(Socrates *socrates)
 {
     // TO-DO: tell studentworld to give user 300 points
@@ -620,6 +801,8 @@ ExtraLifeGoodie::ExtraLifeGoodie(int remainingTicks, StudentWorld* world, double
 
 ExtraLifeGoodie::~ExtraLifeGoodie() {}
 
+ActorType ExtraLifeGoodie::getType() const { return ActorType::extraLifeGoodie; }
+
 void ExtraLifeGoodie::pickUp(Socrates *socrates)
 {
     // TO-DO: user gets 500 points
@@ -635,6 +818,8 @@ Fungus::Fungus(int remainingTicks, StudentWorld* world, double startX, double st
 
 Fungus::~Fungus() {}
 
+ActorType Fungus::getType() const { return ActorType::fungus; }
+
 void Fungus::pickUp(Socrates *socrates)
 {
     // TO-DO: user gets -50 points
@@ -677,6 +862,18 @@ int Projectile::getTravelDist() const { return this->travelDistance; }
 
 void Projectile::setTravelDist(int dist) { this->travelDistance = dist; }
 
+void Projectile::writeState(SnapshotWriter& out) const
+{
+    Actor::writeState(out);
+    out.writeInt(travelDistance);
+}
+
+void Projectile::readState(SnapshotReader& in)
+{
+    Actor::readState(in);
+    travelDistance = in.readInt();
+}
+
 // FLAME ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Flame::Flame(StudentWorld* world, int startX, int startY, int startDirection)
 : Projectile(32 + SPRITE_WIDTH, world, IID_FLAME, startX, startY, startDirection, 1)
@@ -684,6 +881,8 @@ Flame::Flame(StudentWorld* world, int startX, int startY, int startDirection)
 
 Flame::~Flame() {}
 
+ActorType Flame::getType() const { return ActorType::flame; }
+
 void Flame::doSomething() { Projectile::doSomething(); }
 
 int Flame::getDamage() const { return 5; }
@@ -696,6 +895,8 @@ DisinfectantSpray::DisinfectantSpray(StudentWorld* world, int startX, int startY
 
 DisinfectantSpray::~DisinfectantSpray() {}
 
+ActorType DisinfectantSpray::getType() const { return ActorType::disinfectantSpray; }
+
 void DisinfectantSpray::doSomething() { Projectile::doSomething(); }
 
 int DisinfectantSpray::getDamage() const { return 2; }
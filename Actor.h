@@ -2,10 +2,14 @@
 #define ACTOR_H_
 
 #include "GraphObject.h"
+#include "ActorType.h"
 
 #include "StudentWorld.h"
 // We use include instead of forward-declaring the class bc we need to use its functions
 
+class SnapshotWriter;
+class SnapshotReader;
+
 class Actor : public GraphObject
 {
 public:
@@ -15,10 +19,22 @@ public:
     
     virtual ~Actor();
     
+    // operator new / operator delete
+    // Actors live in their world's ActorPool, so they are created with
+    //   new (world) Food(world, x, y);
+    // and deleted as usual.
+    static void* operator new(std::size_t size, StudentWorld* world);
+    static void operator delete(void* p, StudentWorld* world);
+    static void operator delete(void* p);
+    
     // doSomething()
     // Holds logic for what our actor does.
     virtual void doSomething() = 0;
     
+    // getType()
+    // Returns the concrete class of our actor.
+    virtual ActorType getType() const = 0;
+    
     // isAlive()
     // Returns the status of our actor.
     // (Alive/Dead) -> (true/false), respectively.
@@ -61,12 +77,50 @@ public:
     // preventsLevelCompletion()
     // Returns true if Actor prevents level completion
     virtual bool preventsLevelCompletion() const;
+    
+    // moveTo(double x, double y)
+    // Moves the Actor and lets StudentWorld re-bucket it in its spatial grid.
+    virtual void moveTo(double x, double y);
+    
+    // getID() / setID(int id)
+    // Order in which StudentWorld added the Actor. Queries that must pick
+    // "the first" matching Actor use the lowest ID.
+    int getID() const;
+    void setID(int id);
+    
+    // getGridCell() / setGridCell(int cell)
+    // Cell of StudentWorld's spatial grid the Actor is bucketed in, or -1.
+    int getGridCell() const;
+    void setGridCell(int cell);
+    
+    // getGridSlot() / setGridSlot(int slot)
+    // Index of the Actor within its grid cell's arrays.
+    int getGridSlot() const;
+    void setGridSlot(int slot);
 
+    // getHandle()
+    // Slot of the Actor's state in its world's ActorComponents, which is
+    // where its world, position, direction and the rest of it live.
+    ActorComponents::Handle getHandle() const;
+    
+    // writeState(SnapshotWriter& out) const / readState(SnapshotReader& in)
+    // Save and restore whatever a snapshot needs beyond the type, ID,
+    // position and direction StudentWorld records for every Actor.
+    // Overrides start with their base class's part.
+    virtual void writeState(SnapshotWriter& out) const;
+    virtual void readState(SnapshotReader& in);
+
+protected:
+    // components()
+    // Returns the arrays this Actor's state lives in.
+    ActorComponents& components() const;
     
-private:
-    bool status;
-    StudentWorld* m_world;
+    // randInt(int min, int max)
+    // Returns a uniformly distributed random int from min to max, inclusive,
+    // from this Actor's own random stream (see CounterRandom).
+    int randInt(int min, int max);
     
+private:
     virtual void playDeathSound() const;
 };
 
@@ -76,6 +130,8 @@ public:
     Dirt(StudentWorld* world, double startX, double startY);
     ~Dirt();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
     
     virtual bool blocks() const;
@@ -90,9 +146,14 @@ public:
     Pit(StudentWorld* world, double startX, double startY);
     virtual ~Pit();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
     
     virtual bool preventsLevelCompletion() const;
+    
+    virtual void writeState(SnapshotWriter& out) const;
+    virtual void readState(SnapshotReader& in);
 private:
     bool pitEmpty() const;
     int bacteriaArr[3] = {5, 3, 2};
@@ -117,11 +178,11 @@ public:
     
     int getHP() const;
     
+    virtual void writeState(SnapshotWriter& out) const;
+    virtual void readState(SnapshotReader& in);
+    
 protected:
     void setHP(int hp);
-    
-private:
-    int hp;
 };
 
 
@@ -132,6 +193,8 @@ public:
     Socrates(StudentWorld* world, int startX=0, int startY=VIEW_RADIUS);
     virtual ~Socrates();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
             
     virtual void incHP(int inc);
@@ -144,6 +207,9 @@ public:
     
     int getSprayCharges() const;
     
+    virtual void writeState(SnapshotWriter& out) const;
+    virtual void readState(SnapshotReader& in);
+    
 private:
     void move(const int KEY_PRESS);
     int sprayCharges;
@@ -180,6 +246,14 @@ public:
     // Holds logic for when a Bacterium overlaps with an edible Actor.
     void eat(Actor* edible);
     
+    // commitIntent()
+    // Applies what this Bacterium did to the rest of the world during the
+    // first phase of a parallel update (see StudentWorld::setUpdateThreads).
+    void commitIntent();
+    
+    virtual void writeState(SnapshotWriter& out) const;
+    virtual void readState(SnapshotReader& in);
+    
 protected:
     int getFood() const;
     int getMovementDistancePlan() const;
@@ -190,9 +264,16 @@ protected:
     
 private:
     virtual void addBacterium(double newX, double newY) const = 0;
-    int nFood;
-    int movementDistancePlan;
-    bool overlapsWithSocrates;
+    
+    // Effects on other actors held back until commitIntent().
+    struct Intent
+    {
+        bool hitsSocrates = false;
+        bool multiplies = false;
+        ActorComponents::Handle food = -1;
+        double newX = 0, newY = 0;
+    };
+    Intent intent;
 };
 
 class Salmonella : public Bacterium
@@ -212,6 +293,8 @@ public:
 private:
     virtual void playDeathSound() const;
     
+    // The last nearest-food search, reused while it still holds.
+    StudentWorld::EdibleTarget foodTarget;
 };
 
 class RegularSalmonella : public Salmonella
@@ -220,6 +303,8 @@ public:
     RegularSalmonella(StudentWorld* world, double startX, double startY);
     virtual ~RegularSalmonella();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
     
 protected:
@@ -236,6 +321,8 @@ public:
     AggressiveSalmonella(StudentWorld* world, double startX, double startY);
     ~AggressiveSalmonella();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
     
 protected:
@@ -251,6 +338,8 @@ public:
     EColi(StudentWorld* world, double startX, double startY);
     ~EColi();
     
+    virtual ActorType getType() const;
+    
     virtual void takeDamage(int damage);
     
     virtual bool move();
@@ -263,6 +352,11 @@ protected:
     
 private:
     virtual void addBacterium(double newX, double newY) const;
+    
+    // moveTurning(int attempts)
+    // Tries to move 2 pixels on, turning 10 degrees after each blocked try,
+    // up to attempts times. Returns true if it moved.
+    bool moveTurning(int attempts);
 };
 
 class Goodie: public Actor
@@ -281,6 +375,9 @@ public:
     
     virtual void activate(Actor* toThisGuy) {}
     
+    virtual void writeState(SnapshotWriter& out) const;
+    virtual void readState(SnapshotReader& in);
+    
 protected:
     // pickUp(Socrates* socrates)
     // Holds logic for what happens to Socrates and the Goodie when it is picked up.
@@ -296,6 +393,8 @@ public:
     RestoreHealthGoodie(int remainingTicks, StudentWorld* world, double startX, double startY);
     virtual ~RestoreHealthGoodie();
     
+    virtual ActorType getType() const;
+    
 protected:
     virtual void pickUp(Socrates* socrates);
 };
@@ -305,6 +404,8 @@ class FlamethrowerGoodie : public Goodie
 public:
     FlamethrowerGoodie(int remainingTicks, StudentWorld* world, double startX, double startY);
     virtual ~FlamethrowerGoodie();
+    
+    virtual ActorType getType() const;
         
 protected:
     virtual void pickUp(Socrates* socrates);
@@ -316,6 +417,8 @@ public:
     ExtraLifeGoodie(int remainingTicks, StudentWorld* world, double startX, double startY);
     virtual ~ExtraLifeGoodie();
     
+    virtual ActorType getType() const;
+    
 protected:
     virtual void pickUp(Socrates* socrates);
 };
@@ -326,6 +429,8 @@ public:
     Fungus(int remainingTicks, StudentWorld* world, double startX, double startY);
     virtual ~Fungus();
     
+    virtual ActorType getType() const;
+    
 protected:
     virtual void pickUp(Socrates* socrates);
 };
@@ -336,6 +441,8 @@ public:
     Food(StudentWorld* world, int startX, int startY);
     virtual ~Food();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
     
     virtual bool isEdible() const;
@@ -360,6 +467,9 @@ public:
     
     void setTravelDist(int dist);
     
+    virtual void writeState(SnapshotWriter& out) const;
+    virtual void readState(SnapshotReader& in);
+    
 private:
     int travelDistance;
 };
@@ -370,6 +480,8 @@ public:
     Flame(StudentWorld* world, int startX, int startY, int startDirection);
     ~Flame();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
     
     virtual int getDamage() const;
@@ -382,6 +494,8 @@ public:
     DisinfectantSpray(StudentWorld* world, int startX, int startY, int startDirection);
     ~DisinfectantSpray();
     
+    virtual ActorType getType() const;
+    
     virtual void doSomething();
     
     virtual int getDamage() const;
@@ -0,0 +1,88 @@
+#include "ActorComponents.h"
+#include "StudentWorld.h"
+
+ActorComponents::ActorComponents(StudentWorld* world)
+: GraphObjectStore(&world->graphObjects())
+{
+    m_world = world;
+    m_pendingDeaths = 0;
+}
+
+ActorComponents::Handle ActorComponents::acquire(Actor* actor)
+{
+    Handle h;
+    if (!m_free.empty())
+    {
+        h = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        h = static_cast<Handle>(m_alive.size());
+        m_actors.push_back(nullptr);
+        m_generations.push_back(0);
+        m_alive.push_back(0);
+        m_types.push_back(0);
+        m_hp.push_back(0);
+        m_food.push_back(0);
+        m_movementPlan.push_back(0);
+        m_ids.push_back(0);
+        m_gridCells.push_back(0);
+        m_gridSlots.push_back(0);
+        m_randomTicks.push_back(0);
+        m_randomDraws.push_back(0);
+        addSlot();
+    }
+
+    m_actors[h] = actor;
+    m_alive[h] = 1;
+    m_types[h] = 0;
+    m_hp[h] = 0;
+    m_food[h] = 0;
+    m_movementPlan[h] = 0;
+    m_ids[h] = -1;
+    m_gridCells[h] = -1;
+    m_gridSlots[h] = -1;
+    m_randomTicks[h] = -1;
+    m_randomDraws[h] = 0;
+    return h;
+}
+
+void ActorComponents::release(Handle h)
+{
+    m_actors[h] = nullptr;
+    m_generations[h]++;
+    m_alive[h] = 0;
+    m_free.push_back(h);
+}
+
+void ActorComponents::reset()
+{
+    // Next level's actors fill the arrays from the front again, in the order
+    // they are created.
+    m_actors.clear();
+    m_generations.clear();
+    m_alive.clear();
+    m_types.clear();
+    m_hp.clear();
+    m_food.clear();
+    m_movementPlan.clear();
+    m_ids.clear();
+    m_gridCells.clear();
+    m_gridSlots.clear();
+    m_randomTicks.clear();
+    m_randomDraws.clear();
+    clearSlots();
+    m_free.clear();
+    m_pendingDeaths = 0;
+}
+
+int ActorComponents::size() const
+{
+    return static_cast<int>(m_alive.size() - m_free.size());
+}
+
+int ActorComponents::capacity() const
+{
+    return static_cast<int>(m_alive.size());
+}
@@ -0,0 +1,151 @@
+#ifndef ACTORCOMPONENTS_H_
+#define ACTORCOMPONENTS_H_
+
+#include "ActorType.h"
+#include "GraphObject.h"
+#include <cstdint>
+#include <vector>
+
+class Actor;
+class StudentWorld;
+
+// ActorComponents
+// Everything a world keeps per Actor apart from the per-class extras, split
+// out of the Actor objects into dense arrays: position and direction (in the
+// GraphObjectStore part), whether it is alive, its type, the hit points, food
+// eaten and movement plan that HealthyActor and Bacterium work with, and the
+// ID, grid bookkeeping and random-stream position Actor itself needs. An
+// Actor is left holding little more than its slot; its accessors read and
+// write through it. Each Actor is handed a slot when it is constructed and
+// gives it back when it is destroyed. Slots are reused, so the arrays are only
+// as long as the most actors alive at once.
+//
+// Per-class state such as a Pit's bacteria, a Goodie's lifetime or a
+// Projectile's range stays in the objects, as do the framework's drawing
+// details (image, animation frame, depth and size).
+class ActorComponents : public GraphObjectStore
+{
+public:
+    typedef int Handle;
+
+    // Ref
+    // Names an Actor in a way that is safe to hold across ticks. Once the
+    // Actor is destroyed its slot's generation moves on, so the Ref goes
+    // stale instead of pointing at whatever reuses the slot.
+    struct Ref
+    {
+        Handle handle = -1;
+        std::uint32_t generation = 0;
+    };
+
+    // ActorComponents(StudentWorld* world)
+    // Arrays for world's actors, which are drawn from its graphObjects().
+    explicit ActorComponents(StudentWorld* world);
+
+    // world()
+    // Returns the world these actors are in.
+    StudentWorld* world() const { return m_world; }
+
+    // acquire(Actor* actor)
+    // Returns a free slot for actor, set up as living with no ID, outside the
+    // grid and with everything else zero.
+    Handle acquire(Actor* actor);
+
+    // release(Handle h)
+    // Gives slot h back for reuse, making every Ref to it stale.
+    void release(Handle h);
+
+    // ref(Handle h)
+    // Returns a Ref to the Actor in slot h.
+    Ref ref(Handle h) const { return Ref{h, m_generations[h]}; }
+
+    // actor(const Ref& ref)
+    // Returns the Actor ref names, or nullptr if it has been destroyed.
+    Actor* actor(const Ref& ref) const
+    {
+        if (ref.handle < 0 || ref.handle >= capacity() || m_generations[ref.handle] != ref.generation)
+            return nullptr;
+        return m_actors[ref.handle];
+    }
+
+    // reset()
+    // Forgets every slot at once, keeping the arrays' memory. Every Actor
+    // holding a slot (or a Ref) must already have been destroyed.
+    void reset();
+
+    // size()
+    // Returns how many slots are handed out.
+    int size() const;
+
+    // capacity()
+    // Returns how many slots exist, handed out or free.
+    int capacity() const;
+
+    bool isAlive(Handle h) const { return m_alive[h] != 0; }
+    void setAlive(Handle h, bool alive)
+    {
+        if (m_alive[h] && !alive)
+            m_pendingDeaths++;
+        m_alive[h] = alive;
+    }
+
+    // pendingDeaths() / clearPendingDeaths()
+    // How many actors have died since the count was last cleared, so the
+    // dead-actor sweep can skip ticks where nothing died.
+    int pendingDeaths() const { return m_pendingDeaths; }
+    void clearPendingDeaths() { m_pendingDeaths = 0; }
+
+    ActorType type(Handle h) const { return static_cast<ActorType>(m_types[h]); }
+    void setType(Handle h, ActorType type) { m_types[h] = static_cast<std::uint8_t>(type); }
+
+    int hp(Handle h) const { return m_hp[h]; }
+    void setHP(Handle h, int hp) { m_hp[h] = hp; }
+
+    int food(Handle h) const { return m_food[h]; }
+    void setFood(Handle h, int food) { m_food[h] = food; }
+
+    int movementPlan(Handle h) const { return m_movementPlan[h]; }
+    void setMovementPlan(Handle h, int plan) { m_movementPlan[h] = plan; }
+
+    int id(Handle h) const { return m_ids[h]; }
+    void setID(Handle h, int id) { m_ids[h] = id; }
+
+    int gridCell(Handle h) const { return m_gridCells[h]; }
+    void setGridCell(Handle h, int cell) { m_gridCells[h] = cell; }
+
+    int gridSlot(Handle h) const { return m_gridSlots[h]; }
+    void setGridSlot(Handle h, int slot) { m_gridSlots[h] = slot; }
+
+    // randomTick() / randomDraws()
+    // Which tick an Actor last rolled in and how many times it rolled then;
+    // see Actor::randInt.
+    long randomTick(Handle h) const { return m_randomTicks[h]; }
+    std::uint32_t randomDraws(Handle h) const { return m_randomDraws[h]; }
+    void setRandomPosition(Handle h, long tick, std::uint32_t draws)
+    {
+        m_randomTicks[h] = tick;
+        m_randomDraws[h] = draws;
+    }
+
+    ActorComponents(const ActorComponents&) = delete;
+    ActorComponents& operator=(const ActorComponents&) = delete;
+
+private:
+    StudentWorld* m_world;
+    std::vector<Actor*> m_actors;
+    std::vector<std::uint32_t> m_generations;
+    std::vector<std::uint8_t> m_alive;
+    std::vector<std::uint8_t> m_types;
+    std::vector<int> m_hp;
+    std::vector<int> m_food;
+    std::vector<int> m_movementPlan;
+    std::vector<int> m_ids;
+    std::vector<int> m_gridCells;
+    std::vector<int> m_gridSlots;
+    std::vector<long> m_randomTicks;
+    std::vector<std::uint32_t> m_randomDraws;
+    std::vector<Handle> m_free;
+    int m_pendingDeaths;
+};
+
+#endif // ACTORCOMPONENTS_H_
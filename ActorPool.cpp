@@ -0,0 +1,134 @@
+#include "ActorPool.h"
+#include <new>
+
+ActorPool::ActorPool()
+{
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        m_classes[i].chunkIndex = 0;
+        m_classes[i].slotIndex = 0;
+        m_classes[i].freeList = nullptr;
+    }
+    m_stats = Stats();
+}
+
+ActorPool::~ActorPool()
+{
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        for (std::size_t c = 0; c < m_classes[i].chunks.size(); c++)
+            ::operator delete(m_classes[i].chunks[c]);
+    }
+    for (std::size_t i = 0; i < m_oversized.size(); i++)
+        ::operator delete(m_oversized[i]);
+}
+
+void* ActorPool::allocate(std::size_t size)
+{
+    m_stats.allocations++;
+    m_stats.live++;
+
+    int sizeClass = static_cast<int>((size + ALIGNMENT - 1) / ALIGNMENT) - 1;
+    if (sizeClass >= NUM_SIZE_CLASSES)
+    {
+        // Nothing in the game is this big, but don't fail if something ever is.
+        m_stats.heapAllocations++;
+        Header* header = static_cast<Header*>(::operator new(HEADER_SIZE + size));
+        header->owner = this;
+        header->sizeClass = OVERSIZED;
+        m_oversized.push_back(header);
+        return reinterpret_cast<char*>(header) + HEADER_SIZE;
+    }
+
+    SizeClass& sc = m_classes[sizeClass];
+    Header* header = nullptr;
+
+    // Hot path: reuse a slot that was given back.
+    if (sc.freeList != nullptr)
+    {
+        void* slot = sc.freeList;
+        sc.freeList = *static_cast<void**>(slot);
+        header = reinterpret_cast<Header*>(static_cast<char*>(slot) - HEADER_SIZE);
+    }
+    else
+    {
+        // Otherwise carve the next unused slot, moving on to (or making) a new chunk when needed.
+        if (sc.slotIndex == SLOTS_PER_CHUNK)
+        {
+            sc.chunkIndex++;
+            sc.slotIndex = 0;
+        }
+        if (sc.chunkIndex == sc.chunks.size())
+        {
+            std::size_t bytes = slotSize(sizeClass) * SLOTS_PER_CHUNK;
+            sc.chunks.push_back(static_cast<char*>(::operator new(bytes)));
+            m_stats.heapAllocations++;
+            m_stats.bytesReserved += bytes;
+        }
+        header = reinterpret_cast<Header*>(sc.chunks[sc.chunkIndex] + sc.slotIndex * slotSize(sizeClass));
+        sc.slotIndex++;
+    }
+
+    header->owner = this;
+    header->sizeClass = sizeClass;
+    return reinterpret_cast<char*>(header) + HEADER_SIZE;
+}
+
+void ActorPool::deallocate(void* p)
+{
+    if (p == nullptr) return;
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(p) - HEADER_SIZE);
+    header->owner->release(header);
+}
+
+void ActorPool::release(Header* header)
+{
+    m_stats.frees++;
+    m_stats.live--;
+
+    if (header->sizeClass == OVERSIZED)
+    {
+        for (std::size_t i = 0; i < m_oversized.size(); i++)
+        {
+            if (m_oversized[i] == header)
+            {
+                m_oversized[i] = m_oversized.back();
+                m_oversized.pop_back();
+                break;
+            }
+        }
+        ::operator delete(header);
+        return;
+    }
+
+    // Push the slot on its class's free list, reusing the object's memory for the link.
+    SizeClass& sc = m_classes[header->sizeClass];
+    void* slot = reinterpret_cast<char*>(header) + HEADER_SIZE;
+    *static_cast<void**>(slot) = sc.freeList;
+    sc.freeList = slot;
+}
+
+void ActorPool::reset()
+{
+    m_stats.resets++;
+    m_stats.live = 0;
+    for (std::size_t i = 0; i < m_oversized.size(); i++)
+        ::operator delete(m_oversized[i]);
+    m_oversized.clear();
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        m_classes[i].chunkIndex = 0;
+        m_classes[i].slotIndex = 0;
+        m_classes[i].freeList = nullptr;
+    }
+}
+
+const ActorPool::Stats& ActorPool::stats() const
+{
+    return m_stats;
+}
+
+std::size_t ActorPool::slotSize(int sizeClass)
+{
+    return HEADER_SIZE + (sizeClass + 1) * ALIGNMENT;
+}
@@ -0,0 +1,79 @@
+#ifndef ACTORPOOL_H_
+#define ACTORPOOL_H_
+
+#include <cstddef>
+#include <vector>
+
+// ActorPool
+// Per-world allocator for the Actor hierarchy. Memory is carved out of large
+// chunks, one set of chunks per size class, and freed slots go on a free list,
+// so spawning a spray, flame, bacterium or food is a free-list pop instead of
+// a trip to the global heap. Chunks are kept when a level ends: reset() marks
+// every slot free at once, and the next level reuses the same memory.
+class ActorPool
+{
+public:
+    // Counters for checking heap traffic. heapAllocations only moves when the
+    // pool has to grow, so it stays put during steady-state ticks.
+    struct Stats
+    {
+        long allocations;       // slots handed out
+        long frees;             // slots given back one at a time
+        long resets;            // whole-pool releases
+        long live;              // slots currently handed out
+        long heapAllocations;   // chunks (and oversized objects) taken from the global heap
+        std::size_t bytesReserved;
+    };
+
+    ActorPool();
+    ~ActorPool();
+
+    // allocate(std::size_t size)
+    // Returns memory for one object of the given size.
+    void* allocate(std::size_t size);
+
+    // deallocate(void* p)
+    // Gives p back to whichever pool allocated it.
+    static void deallocate(void* p);
+
+    // reset()
+    // Marks every slot free without touching them one by one.
+    // Every object in the pool must already have been destroyed.
+    void reset();
+
+    const Stats& stats() const;
+
+    ActorPool(const ActorPool&) = delete;
+    ActorPool& operator=(const ActorPool&) = delete;
+
+private:
+    static const std::size_t ALIGNMENT = 16;
+    static const std::size_t HEADER_SIZE = 16;      // keeps objects 16-byte aligned
+    static const int NUM_SIZE_CLASSES = 16;         // objects up to 256 bytes
+    static const int SLOTS_PER_CHUNK = 256;
+    static const int OVERSIZED = -1;
+
+    // Written in front of every object so deallocate() can find its pool.
+    struct Header
+    {
+        ActorPool* owner;
+        int sizeClass;
+    };
+
+    struct SizeClass
+    {
+        std::vector<char*> chunks;
+        std::size_t chunkIndex; // chunk currently being carved
+        int slotIndex;          // next never-used slot in that chunk
+        void* freeList;         // slots given back since the last reset()
+    };
+
+    SizeClass m_classes[NUM_SIZE_CLASSES];
+    std::vector<Header*> m_oversized;
+    Stats m_stats;
+
+    static std::size_t slotSize(int sizeClass);
+    void release(Header* header);
+};
+
+#endif // ACTORPOOL_H_
@@ -0,0 +1,39 @@
+#ifndef ACTORTYPE_H_
+#define ACTORTYPE_H_
+
+// ActorType
+// Concrete class of an Actor. StudentWorld uses it to file each Actor into
+// a category once, instead of asking the virtual predicates every tick.
+enum class ActorType
+{
+    socrates, dirt, pit, regularSalmonella, aggressiveSalmonella, eColi,
+    restoreHealthGoodie, flamethrowerGoodie, extraLifeGoodie, fungus,
+    food, flame, disinfectantSpray
+};
+
+const int NUM_ACTOR_TYPES = 13;
+
+// actorTypeName(ActorType type)
+// Returns the class name of the type, for reports.
+inline const char* actorTypeName(ActorType type)
+{
+    switch (type)
+    {
+        case ActorType::socrates:               return "Socrates";
+        case ActorType::dirt:                   return "Dirt";
+        case ActorType::pit:                    return "Pit";
+        case ActorType::regularSalmonella:      return "RegularSalmonella";
+        case ActorType::aggressiveSalmonella:   return "AggressiveSalmonella";
+        case ActorType::eColi:                  return "EColi";
+        case ActorType::restoreHealthGoodie:    return "RestoreHealthGoodie";
+        case ActorType::flamethrowerGoodie:     return "FlamethrowerGoodie";
+        case ActorType::extraLifeGoodie:        return "ExtraLifeGoodie";
+        case ActorType::fungus:                 return "Fungus";
+        case ActorType::food:                   return "Food";
+        case ActorType::flame:                  return "Flame";
+        case ActorType::disinfectantSpray:      return "DisinfectantSpray";
+    }
+    return "?";
+}
+
+#endif // ACTORTYPE_H_
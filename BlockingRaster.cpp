@@ -0,0 +1,107 @@
+#include "BlockingRaster.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace
+{
+    // Far wider than the rounding error of either exact test, far narrower
+    // than a pixel.
+    const double MARGIN = 1e-6;
+
+    // Squared distance from (x,y) to the nearest and to the farthest point
+    // of the pixel with top-left corner (px,py).
+    double nearestSquared(int px, int py, double x, double y)
+    {
+        double dx = max(max(px - x, x - (px + 1)), 0.0);
+        double dy = max(max(py - y, y - (py + 1)), 0.0);
+        return dx * dx + dy * dy;
+    }
+
+    double farthestSquared(int px, int py, double x, double y)
+    {
+        double dx = max(fabs(px - x), fabs(px + 1 - x));
+        double dy = max(fabs(py - y), fabs(py + 1 - y));
+        return dx * dx + dy * dy;
+    }
+}
+
+BlockingRaster::BlockingRaster(const DistanceKernel::Radius& obstacleRadius)
+    : m_radius(obstacleRadius),
+      m_touching(NUM_PIXELS, 0),
+      m_covering(NUM_PIXELS, 0),
+      m_edge(NUM_PIXELS, INSIDE),
+      m_clear(WORDS_PER_ROW * VIEW_HEIGHT, 0),
+      m_blocked(WORDS_PER_ROW * VIEW_HEIGHT, 0)
+{
+    // The exact test blocks at sqrt(d2) >= VIEW_RADIUS from the centre.
+    const double centreX = VIEW_WIDTH/2, centreY = VIEW_HEIGHT/2;
+    for (int py = 0; py < VIEW_HEIGHT; py++)
+    {
+        for (int px = 0; px < VIEW_WIDTH; px++)
+        {
+            int pixel = py * VIEW_WIDTH + px;
+            if (sqrt(farthestSquared(px, py, centreX, centreY)) < VIEW_RADIUS - MARGIN)
+                m_edge[pixel] = INSIDE;
+            else if (sqrt(nearestSquared(px, py, centreX, centreY)) > VIEW_RADIUS + MARGIN)
+                m_edge[pixel] = OUTSIDE;
+            else
+                m_edge[pixel] = ACROSS;
+            refresh(pixel);
+        }
+    }
+}
+
+void BlockingRaster::addObstacle(double x, double y)
+{
+    changeObstacle(x, y, 1);
+}
+
+void BlockingRaster::removeObstacle(double x, double y)
+{
+    changeObstacle(x, y, -1);
+}
+
+void BlockingRaster::clearObstacles()
+{
+    for (int pixel = 0; pixel < NUM_PIXELS; pixel++)
+    {
+        if (m_touching[pixel] == 0)
+            continue;
+        m_touching[pixel] = 0;
+        m_covering[pixel] = 0;
+        refresh(pixel);
+    }
+}
+
+void BlockingRaster::changeObstacle(double x, double y, int delta)
+{
+    // Every pixel the disc can reach, clipped to the raster.
+    int minX = max(static_cast<int>(floor(x - m_radius.value)) - 1, 0);
+    int maxX = min(static_cast<int>(floor(x + m_radius.value)) + 1, VIEW_WIDTH - 1);
+    int minY = max(static_cast<int>(floor(y - m_radius.value)) - 1, 0);
+    int maxY = min(static_cast<int>(floor(y + m_radius.value)) + 1, VIEW_HEIGHT - 1);
+    for (int py = minY; py <= maxY; py++)
+    {
+        for (int px = minX; px <= maxX; px++)
+        {
+            int pixel = py * VIEW_WIDTH + px;
+            if (nearestSquared(px, py, x, y) > m_radius.maxDistSquared + MARGIN)
+                continue;
+            m_touching[pixel] += delta;
+            if (farthestSquared(px, py, x, y) < m_radius.maxDistSquared - MARGIN)
+                m_covering[pixel] += delta;
+            refresh(pixel);
+        }
+    }
+}
+
+void BlockingRaster::refresh(int pixel)
+{
+    int word = (pixel / VIEW_WIDTH) * WORDS_PER_ROW + (pixel % VIEW_WIDTH) / 64;
+    uint64_t bit = uint64_t(1) << ((pixel % VIEW_WIDTH) % 64);
+    bool clear = m_edge[pixel] == INSIDE && m_touching[pixel] == 0;
+    bool blocked = m_edge[pixel] == OUTSIDE || m_covering[pixel] > 0;
+    m_clear[word] = clear ? m_clear[word] | bit : m_clear[word] & ~bit;
+    m_blocked[word] = blocked ? m_blocked[word] | bit : m_blocked[word] & ~bit;
+}
@@ -0,0 +1,85 @@
+#ifndef BLOCKINGRASTER_H_
+#define BLOCKINGRASTER_H_
+
+#include "GameConstants.h"
+#include "DistanceKernel.h"
+#include <cstdint>
+#include <vector>
+
+// BlockingRaster
+// One-pixel raster of the dish that answers most "is a bacterium blocked
+// here?" tests with a bit lookup. Every pixel is either clear (no obstacle
+// disc reaches it and it lies inside the dish), blocked (an obstacle disc
+// covers all of it, or it lies outside the dish) or unsure (an edge runs
+// through it). Only unsure pixels need the exact test.
+//
+// Clear and blocked are decided with a margin far wider than any rounding
+// in the exact test, so the raster never disagrees with it. Obstacles are
+// counted per pixel, so adding and removing one only touches the pixels
+// under its disc, and overlapping piles come and go in any order.
+class BlockingRaster
+{
+public:
+    enum Answer
+    {
+        CLEAR, BLOCKED, UNSURE
+    };
+
+    // BlockingRaster(const DistanceKernel::Radius& obstacleRadius)
+    // Movement is blocked within obstacleRadius of an obstacle's centre
+    // and at or beyond VIEW_RADIUS from the centre of the dish.
+    explicit BlockingRaster(const DistanceKernel::Radius& obstacleRadius);
+
+    // addObstacle(double x, double y) / removeObstacle(double x, double y)
+    // Every removeObstacle must match an earlier addObstacle at the same spot.
+    void addObstacle(double x, double y);
+    void removeObstacle(double x, double y);
+
+    // clearObstacles()
+    // Removes every obstacle; the dish edge stays.
+    void clearObstacles();
+
+    // test(double x, double y)
+    // What the raster knows about (x,y). Points off the raster are UNSURE.
+    Answer test(double x, double y) const
+    {
+        if (!(x >= 0 && x < VIEW_WIDTH && y >= 0 && y < VIEW_HEIGHT))
+            return UNSURE;
+        int word = static_cast<int>(y) * WORDS_PER_ROW + static_cast<int>(x) / 64;
+        std::uint64_t bit = std::uint64_t(1) << (static_cast<int>(x) % 64);
+        if (m_clear[word] & bit)
+            return CLEAR;
+        if (m_blocked[word] & bit)
+            return BLOCKED;
+        return UNSURE;
+    }
+
+    BlockingRaster(const BlockingRaster&) = delete;
+    BlockingRaster& operator=(const BlockingRaster&) = delete;
+
+private:
+    static const int WORDS_PER_ROW = (VIEW_WIDTH + 63) / 64;
+    static const int NUM_PIXELS = VIEW_WIDTH * VIEW_HEIGHT;
+
+    DistanceKernel::Radius m_radius;
+    std::vector<std::uint16_t> m_touching;  // obstacle discs reaching into each pixel
+    std::vector<std::uint16_t> m_covering;  // obstacle discs containing each pixel whole
+    std::vector<std::uint8_t> m_edge;       // per pixel, an EdgeState
+    std::vector<std::uint64_t> m_clear;
+    std::vector<std::uint64_t> m_blocked;
+
+    enum EdgeState
+    {
+        INSIDE, OUTSIDE, ACROSS
+    };
+
+    // changeObstacle(double x, double y, int delta)
+    // Adds delta to the counts of every pixel the disc at (x,y) reaches.
+    void changeObstacle(double x, double y, int delta);
+
+    // refresh(int pixel)
+    // Recomputes pixel's clear and blocked bits from its counts.
+    void refresh(int pixel);
+};
+
+#endif // BLOCKINGRASTER_H_
@@ -0,0 +1,233 @@
+#include "DistanceKernel.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DISTANCEKERNEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DISTANCEKERNEL_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // better(double d, int id, double bestDistance, int bestID)
+    // The nearest-search rule the game has always used.
+    inline bool better(double d, int id, double bestDistance, int bestID)
+    {
+        return d < bestDistance || (bestID >= 0 && d == bestDistance && id < bestID);
+    }
+
+    // foldCandidates(...)
+    // Applies the rule, in index order, to the points in candidates (a mask of
+    // points already known to be no farther than the best at the start).
+    inline int foldCandidates(uint64_t candidates, const double* distances, const int* ids,
+                              double& bestDistance, int& bestID)
+    {
+        int best = -1;
+        for (int i = 0; candidates != 0; i++, candidates >>= 1)
+        {
+            if ((candidates & 1) && better(distances[i], ids[i], bestDistance, bestID))
+            {
+                bestDistance = distances[i];
+                bestID = ids[i];
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    uint64_t hitMaskScalar(const double* xs, const double* ys, int n, double x, double y, double maxDistSquared)
+    {
+        uint64_t mask = 0;
+        for (int i = 0; i < n; i++)
+        {
+            double dx = xs[i] - x, dy = ys[i] - y;
+            if (dx * dx + dy * dy <= maxDistSquared)
+                mask |= uint64_t(1) << i;
+        }
+        return mask;
+    }
+
+    int nearestScalar(const double* xs, const double* ys, const int* ids, int n,
+                      double x, double y, double& bestDistance, int& bestID)
+    {
+        int best = -1;
+        for (int i = 0; i < n; i++)
+        {
+            double dx = xs[i] - x, dy = ys[i] - y;
+            double d = sqrt(dx * dx + dy * dy);
+            if (better(d, ids[i], bestDistance, bestID))
+            {
+                bestDistance = d;
+                bestID = ids[i];
+                best = i;
+            }
+        }
+        return best;
+    }
+
+#ifdef DISTANCEKERNEL_SSE2
+    uint64_t hitMaskSse2(const double* xs, const double* ys, int n, double x, double y, double maxDistSquared)
+    {
+        __m128d qx = _mm_set1_pd(x), qy = _mm_set1_pd(y), limit = _mm_set1_pd(maxDistSquared);
+        uint64_t mask = 0;
+        int i = 0;
+        for ( ; i + 2 <= n; i += 2)
+        {
+            __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + i), qx);
+            __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + i), qy);
+            __m128d d2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+            mask |= uint64_t(_mm_movemask_pd(_mm_cmple_pd(d2, limit))) << i;
+        }
+        if (i < n)
+            mask |= hitMaskScalar(xs + i, ys + i, n - i, x, y, maxDistSquared) << i;
+        return mask;
+    }
+
+    int nearestSse2(const double* xs, const double* ys, const int* ids, int n,
+                    double x, double y, double& bestDistance, int& bestID)
+    {
+        __m128d qx = _mm_set1_pd(x), qy = _mm_set1_pd(y), limit = _mm_set1_pd(bestDistance);
+        double distances[DistanceKernel::MAX_BATCH];
+        uint64_t candidates = 0;
+        int i = 0;
+        for ( ; i + 2 <= n; i += 2)
+        {
+            __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + i), qx);
+            __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + i), qy);
+            __m128d d = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+            _mm_storeu_pd(distances + i, d);
+            candidates |= uint64_t(_mm_movemask_pd(_mm_cmple_pd(d, limit))) << i;
+        }
+        for ( ; i < n; i++)
+        {
+            double dx = xs[i] - x, dy = ys[i] - y;
+            distances[i] = sqrt(dx * dx + dy * dy);
+            if (distances[i] <= bestDistance)
+                candidates |= uint64_t(1) << i;
+        }
+        return foldCandidates(candidates, distances, ids, bestDistance, bestID);
+    }
+#endif
+
+#ifdef DISTANCEKERNEL_AVX2
+    // No FMA here on purpose: a fused multiply-add rounds differently from
+    // the separate multiply and add the scalar code does.
+    __attribute__((target("avx2")))
+    uint64_t hitMaskAvx2(const double* xs, const double* ys, int n, double x, double y, double maxDistSquared)
+    {
+        __m256d qx = _mm256_set1_pd(x), qy = _mm256_set1_pd(y), limit = _mm256_set1_pd(maxDistSquared);
+        uint64_t mask = 0;
+        int i = 0;
+        for ( ; i + 4 <= n; i += 4)
+        {
+            __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), qx);
+            __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), qy);
+            __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            mask |= uint64_t(_mm256_movemask_pd(_mm256_cmp_pd(d2, limit, _CMP_LE_OQ))) << i;
+        }
+        if (i < n)
+            mask |= hitMaskScalar(xs + i, ys + i, n - i, x, y, maxDistSquared) << i;
+        return mask;
+    }
+
+    __attribute__((target("avx2")))
+    int nearestAvx2(const double* xs, const double* ys, const int* ids, int n,
+                    double x, double y, double& bestDistance, int& bestID)
+    {
+        __m256d qx = _mm256_set1_pd(x), qy = _mm256_set1_pd(y), limit = _mm256_set1_pd(bestDistance);
+        double distances[DistanceKernel::MAX_BATCH];
+        uint64_t candidates = 0;
+        int i = 0;
+        for ( ; i + 4 <= n; i += 4)
+        {
+            __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), qx);
+            __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), qy);
+            __m256d d = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+            _mm256_storeu_pd(distances + i, d);
+            candidates |= uint64_t(_mm256_movemask_pd(_mm256_cmp_pd(d, limit, _CMP_LE_OQ))) << i;
+        }
+        for ( ; i < n; i++)
+        {
+            double dx = xs[i] - x, dy = ys[i] - y;
+            distances[i] = sqrt(dx * dx + dy * dy);
+            if (distances[i] <= bestDistance)
+                candidates |= uint64_t(1) << i;
+        }
+        return foldCandidates(candidates, distances, ids, bestDistance, bestID);
+    }
+#endif
+
+    typedef uint64_t (*HitMaskFunc)(const double*, const double*, int, double, double, double);
+    typedef int (*NearestFunc)(const double*, const double*, const int*, int, double, double, double&, int&);
+
+    struct Dispatch
+    {
+        HitMaskFunc hitMask;
+        NearestFunc nearest;
+        const char* name;
+
+        Dispatch()
+        {
+            hitMask = hitMaskScalar;
+            nearest = nearestScalar;
+            name = "scalar";
+#ifdef DISTANCEKERNEL_SSE2
+            hitMask = hitMaskSse2;
+            nearest = nearestSse2;
+            name = "sse2";
+#endif
+#ifdef DISTANCEKERNEL_AVX2
+            if (__builtin_cpu_supports("avx2"))
+            {
+                hitMask = hitMaskAvx2;
+                nearest = nearestAvx2;
+                name = "avx2";
+            }
+#endif
+        }
+    };
+
+    // Picked once at startup, so each call is a plain indirect call.
+    const Dispatch s_dispatch;
+}
+
+DistanceKernel::Radius::Radius(double radius)
+{
+    value = radius;
+    maxDistSquared = squaredThreshold(radius);
+}
+
+double DistanceKernel::squaredThreshold(double radius)
+{
+    // Start from radius^2 and walk to the exact boundary; sqrt is correctly
+    // rounded and monotonic, so it's only ever a step or two.
+    double t = radius * radius;
+    while (sqrt(t) > radius)
+        t = nextafter(t, 0.0);
+    while (sqrt(nextafter(t, HUGE_VAL)) <= radius)
+        t = nextafter(t, HUGE_VAL);
+    return t;
+}
+
+uint64_t DistanceKernel::hitMask(const double* xs, const double* ys, int n,
+                                 double x, double y, const Radius& radius)
+{
+    return s_dispatch.hitMask(xs, ys, n, x, y, radius.maxDistSquared);
+}
+
+int DistanceKernel::nearest(const double* xs, const double* ys, const int* ids, int n,
+                            double x, double y, double& bestDistance, int& bestID)
+{
+    return s_dispatch.nearest(xs, ys, ids, n, x, y, bestDistance, bestID);
+}
+
+const char* DistanceKernel::instructionSet()
+{
+    return s_dispatch.name;
+}
@@ -0,0 +1,61 @@
+#ifndef DISTANCEKERNEL_H_
+#define DISTANCEKERNEL_H_
+
+#include <cstdint>
+
+// DistanceKernel
+// Batched distance tests over positions stored as separate x and y arrays.
+// Uses AVX2 when the CPU has it, SSE2 otherwise on x86, and plain scalar
+// code elsewhere; every path gives identical answers.
+//
+// The game has always tested sqrt(dx*dx + dy*dy) <= r. The kernel compares
+// squared distances against the largest d2 whose sqrt still rounds to <= r
+// (see Radius), which selects exactly the same pairs without the sqrt.
+class DistanceKernel
+{
+public:
+    // Radius
+    // A distance limit together with its exact squared threshold.
+    struct Radius
+    {
+        explicit Radius(double radius);
+
+        double value;
+        double maxDistSquared;  // sqrt(d2) <= value exactly when d2 <= maxDistSquared
+    };
+
+    static constexpr int MAX_BATCH = 64;
+
+    // squaredThreshold(double radius)
+    // Returns the largest double d2 with sqrt(d2) <= radius.
+    static double squaredThreshold(double radius);
+
+    // within(double dx, double dy, const Radius& radius)
+    // Scalar test for one pair.
+    static bool within(double dx, double dy, const Radius& radius)
+    {
+        return dx * dx + dy * dy <= radius.maxDistSquared;
+    }
+
+    // hitMask(const double* xs, const double* ys, int n, double x, double y, const Radius& radius)
+    // Returns a mask with bit i set if point i is within radius of (x,y).
+    // n must be at most MAX_BATCH.
+    static std::uint64_t hitMask(const double* xs, const double* ys, int n,
+                                 double x, double y, const Radius& radius);
+
+    // nearest(const double* xs, const double* ys, const int* ids, int n,
+    //         double x, double y, double& bestDistance, int& bestID)
+    // Folds n points into a running nearest search around (x,y). A point
+    // replaces the current best if its distance is smaller, or equal with a
+    // lower id; while bestID is -1 it has to be strictly inside bestDistance.
+    // Distances are the same correctly rounded sqrt the scalar code takes.
+    // Returns the index of the new best within this batch, or -1.
+    static int nearest(const double* xs, const double* ys, const int* ids, int n,
+                       double x, double y, double& bestDistance, int& bestID);
+
+    // instructionSet()
+    // Returns "avx2", "sse2" or "scalar": the path this CPU uses.
+    static const char* instructionSet();
+};
+
+#endif // DISTANCEKERNEL_H_
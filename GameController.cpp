@@ -5,6 +5,8 @@
 #include "GraphObject.h"
 #include "SoundFX.h"
 #include "SpriteManager.h"
+#include "Trace.h"
+#include "RandomGenerator.h"
 #include <string>
 #include <map>
 #include <utility>
@@ -51,13 +53,19 @@ struct SpriteInfo
 };
 
 static void drawPrompt(string mainMessage, string secondMessage);
-static void drawScoreAndLives(string);
+static void drawScoreAndLives(const char*);
 
 enum GameController::GameControllerState : int {
     welcome, init, makemove, animate, contgame, finishedlevel, cleanup,
     gameover, prompt, quit, not_applicable
 };
 
+// Trace zone names for each state, in the same order as the enum.
+static const char* const stateNames[] = {
+    "welcome", "init", "makemove", "animate", "contgame", "finishedlevel", "cleanup",
+    "gameover", "prompt", "quit", "not_applicable"
+};
+
 void GameController::initDrawersAndSounds()
 {
     SpriteInfo drawers[] = {
@@ -139,6 +147,7 @@ void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTit
     m_singleStep = false;
     m_curIntraFrameTick = 0;
     m_playerWon = false;
+    m_gameStatText = "";
 
     glutInit(&argc, argv);
 
@@ -155,9 +164,20 @@ void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTit
     glutDisplayFunc(doSomethingCallback);
     glutTimerFunc(MS_PER_FRAME, timerFuncCallback, 0);
 
+    // KONTAGION_TRACE=file.json records a timeline of the whole session.
+    const char* tracePath = getenv("KONTAGION_TRACE");
+    if (tracePath != nullptr)
+    {
+        Trace::setThreadName("game loop");
+        Trace::setEnabled(true);
+    }
+
     glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
     glutMainLoop();
     delete m_gw;
+
+    if (tracePath != nullptr && !Trace::writeChromeJson(tracePath))
+        cerr << "Cannot write trace to " << tracePath << endl;
 }
 
 void GameController::keyboardEvent(unsigned char key, int /* x */, int /* y */)
@@ -190,6 +210,7 @@ void GameController::specialKeyboardEvent(int key, int /* x */, int /* y */)
 
 void GameController::playSound(int soundID)
 {
+    TRACE_ZONE("playSound");
     if (soundID == SOUND_NONE)
     {
         SoundFX().abortClip();
@@ -223,6 +244,7 @@ void GameController::quitGame()
 
 void GameController::doSomething()
 {
+    Trace::Zone zone(stateNames[m_gameState], "state");
     switch (m_gameState)
     {
         case not_applicable:
@@ -230,6 +252,7 @@ void GameController::doSomething()
         case welcome:
             playSound(SOUND_THEME);
             setGameStateAfterPrompting(init, "Welcome to Kontagion!", "Press Enter to begin play...");
+            m_gw->prepareNextLevel();
             break;
         case init:
             {
@@ -286,10 +309,12 @@ void GameController::doSomething()
         case contgame:
             setGameStateAfterPrompting(cleanup, "You lost a life!",
                                         "Press Enter to continue playing...");
+            m_gw->prepareNextLevel();
             break;
         case finishedlevel:
             setGameStateAfterPrompting(cleanup, "Woot! You finished the level!",
                                         "Press Enter to continue playing...");
+            m_gw->prepareNextLevel();
             break;
         case cleanup:
             m_gw->cleanUp();
@@ -321,6 +346,7 @@ void GameController::doSomething()
 
 void GameController::displayGamePlay()
 {
+    TRACE_ZONE("displayGamePlay");
     glEnable(GL_DEPTH_TEST); // must be done each time before displaying graphics or gets disabled for some reason
     glLoadIdentity();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -333,12 +359,18 @@ void GameController::displayGamePlay()
 #pragma GCC diagnostic pop
 #endif
 
-    GraphObject::drawAllObjects(
-        [=](int imageID, int animationNumber, double x, double y, int angle, double size)
-        {
-            int frame = animationNumber % m_spriteManager.getNumFrames(imageID);
-            m_spriteManager.plotSprite(imageID, frame, x, y, angle, size);
-        });
+    {
+        Trace::Zone batch("plotSprite batch", "render");
+        int sprites = 0;
+        GraphObject::drawAllObjects(m_gw->graphObjects(),
+            [=, &sprites](int imageID, int animationNumber, double x, double y, int angle, double size)
+            {
+                int frame = animationNumber % m_spriteManager.getNumFrames(imageID);
+                m_spriteManager.plotSprite(imageID, frame, x, y, angle, size);
+                sprites++;
+            });
+        batch.setCount(sprites);
+    }
 
     drawScoreAndLives(m_gameStatText);
 
@@ -402,14 +434,16 @@ static void drawPrompt(string mainMessage, string secondMessage)
     glutSwapBuffers();
 }
 
-static void drawScoreAndLives(string gameStatText)
+static void drawScoreAndLives(const char* gameStatText)
 {
     static int RATE = 1;
+    // Only the status line's shimmer draws from this; it never touches a world.
+    static RandomGenerator shimmer(1);
     static GLfloat rgb[3] =
         { static_cast<GLfloat>(.6), static_cast<GLfloat>(.6), static_cast<GLfloat>(.6) };
     for (int k = 0; k < 3; k++)
     {
-        double strength = rgb[k] + randInt(-RATE, RATE) / 100.0;
+        double strength = rgb[k] + shimmer.randInt(-RATE, RATE) / 100.0;
         if (strength < .6)
             strength = .6;
         else if (strength > 1.0)
@@ -417,5 +451,5 @@ static void drawScoreAndLives(string gameStatText)
         rgb[k] = static_cast<GLfloat>(strength);
     }
     glColor3f(rgb[0], rgb[1], rgb[2]);
-    outputStrokeCentered(SCORE_Y, SCORE_Z, gameStatText.c_str());
+    outputStrokeCentered(SCORE_Y, SCORE_Z, gameStatText);
 }
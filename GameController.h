@@ -2,6 +2,7 @@
 #define GAMECONTROLLER_H_
 
 #include "SpriteManager.h"
+#include "WorldController.h"
 #include <string>
 #include <map>
 #include <iostream>
@@ -12,12 +13,12 @@ const int INVALID_KEY = 0;
 class GraphObject;
 class GameWorld;
 
-class GameController
+class GameController : public WorldController
 {
   public:
     void run(int argc, char* argv[], GameWorld* gw, std::string windowTitle);
 
-    bool getLastKey(int& value)
+    virtual bool getLastKey(int& value)
     {
         if (m_lastKeyHit != INVALID_KEY)
         {
@@ -28,9 +29,9 @@ class GameController
         return false;
     }
 
-    void playSound(int soundID);
+    virtual void playSound(int soundID);
 
-    void setGameStatText(std::string text)
+    virtual void setGameStatText(const char* text)
     {
         m_gameStatText = text;
     }
@@ -41,7 +42,7 @@ class GameController
     void keyboardEvent(unsigned char key, int x, int y);
     void specialKeyboardEvent(int key, int x, int y);
 
-    void quitGame();
+    virtual void quitGame();
 
       // Meyers singleton pattern
     static GameController& getInstance()
@@ -59,7 +60,7 @@ private:
     GameControllerState m_nextStateAfterAnimate;
     int         m_lastKeyHit;
     bool        m_singleStep;
-    std::string m_gameStatText;
+    const char* m_gameStatText;
     std::string m_mainMessage;
     std::string m_secondMessage;
     int         m_curIntraFrameTick;
@@ -1,5 +1,5 @@
 #include "GameWorld.h"
-#include "GameController.h"
+#include "WorldController.h"
 #include <string>
 #include <cstdlib>
 using namespace std;
@@ -21,7 +21,7 @@ void GameWorld::playSound(int soundID)
     m_controller->playSound(soundID);
 }
 
-void GameWorld::setGameStatText(string text)
+void GameWorld::setGameStatText(const char* text)
 {
     m_controller->setGameStatText(text);
 }
@@ -2,11 +2,12 @@
 #define GAMEWORLD_H_
 
 #include "GameConstants.h"
+#include "GraphObject.h"
 #include <string>
 
 const int START_PLAYER_LIVES = 3;
 
-class GameController;
+class WorldController;
 
 class GameWorld
 {
@@ -26,7 +27,16 @@ public:
     virtual int move() = 0;
     virtual void cleanUp() = 0;
 
-    void setGameStatText(std::string text);
+      // Called while the controller waits on the player before a level (the
+      // prompts), when the next calls it makes will be init() and, if a
+      // level was being played, cleanUp() before that. A world may start on
+      // both in the background; the controller doesn't touch it again until
+      // it calls them. Does nothing by default.
+    virtual void prepareNextLevel()
+    {
+    }
+
+    void setGameStatText(const char* text);
 
     bool getKey(int& value);
     void playSound(int soundID);
@@ -65,6 +75,17 @@ public:
     {
         return m_assetPath;
     }
+
+      // Everything in this world that gets drawn
+    GraphObjectRegistry& graphObjects()
+    {
+        return m_graphObjects;
+    }
+
+    const GraphObjectRegistry& graphObjects() const
+    {
+        return m_graphObjects;
+    }
     
       // The following should be used by only the framework, not the student
 
@@ -77,8 +98,16 @@ public:
     {
         ++m_level;
     }
+
+      // Puts a saved game's level, lives and score back
+    void setProgress(int level, int lives, int score)
+    {
+        m_level = level;
+        m_lives = lives;
+        m_score = score;
+    }
    
-    void setController(GameController* controller)
+    void setController(WorldController* controller)
     {
         m_controller = controller;
     }
@@ -87,8 +116,9 @@ private:
     int m_lives;
     int m_score;
     int m_level;
-    GameController* m_controller;
+    WorldController* m_controller;
     std::string     m_assetPath;
+    GraphObjectRegistry m_graphObjects;
 };
 
 #endif // GAMEWORLD_H_
@@ -1,16 +1,126 @@
 #ifndef GRAPHOBJ_H_
 #define GRAPHOBJ_H_
 
-#include "SpriteManager.h"
 #include "GameConstants.h"
+#include "Trig.h"
 
-#include <set>
+#include <vector>
 #include <cmath>
 
 const int ANIMATION_POSITIONS_PER_TICK = 1;
 
 using Direction = int;
 
+class GraphObject;
+
+  // Everything one world has to draw, bucketed by depth. Each GraphObject
+  // remembers its slot, so adding and removing one is O(1): a removed slot is
+  // just emptied, and a bucket squeezes its empty slots out once they make up
+  // half of it. Within a depth, objects are drawn in the order they were created.
+class GraphObjectRegistry
+{
+  public:
+    static const int NUM_DEPTHS = 4;
+
+    GraphObjectRegistry() {}
+
+    void add(GraphObject* go);
+    void remove(GraphObject* go);
+
+      // Calls f(GraphObject*) for every object, deepest first
+    template<typename Func>
+    void forEach(Func f) const
+    {
+        for (int depth = NUM_DEPTHS - 1; depth >= 0; depth--)
+        {
+            const std::vector<GraphObject*>& slots = m_buckets[depth].slots;
+            for (size_t i = 0; i < slots.size(); i++)
+            {
+                if (slots[i] != nullptr)
+                    f(slots[i]);
+            }
+        }
+    }
+
+      // Prevent copying or assigning registries; GraphObjects point into them
+    GraphObjectRegistry(const GraphObjectRegistry&) = delete;
+    GraphObjectRegistry& operator=(const GraphObjectRegistry&) = delete;
+
+  private:
+    struct Bucket
+    {
+        std::vector<GraphObject*> slots;
+        size_t holes = 0;
+    };
+
+    Bucket m_buckets[NUM_DEPTHS];
+
+    static int bucketFor(int depth)
+    {
+        if (depth >= 0 && depth < NUM_DEPTHS)
+            return depth;
+        else
+            return 0;
+    }
+
+    void compact(Bucket& bucket);
+};
+
+  // Where a set of GraphObjects are and which way they face, kept in dense
+  // arrays instead of in the objects; each GraphObject reads and writes its
+  // own slot. Also names the registry its objects are drawn from (nullptr if
+  // they never are). Slots are handed out by a derived class, which keeps
+  // the rest of its per-object state in arrays alongside these.
+class GraphObjectStore
+{
+  public:
+    typedef int Slot;
+
+    explicit GraphObjectStore(GraphObjectRegistry* registry)
+     : m_registry(registry)
+    {}
+
+    GraphObjectRegistry* registry() const { return m_registry; }
+
+    double x(Slot s) const { return m_x[s]; }
+    double y(Slot s) const { return m_y[s]; }
+    Direction direction(Slot s) const { return m_direction[s]; }
+
+    void setPosition(Slot s, double x, double y)
+    {
+        m_x[s] = x;
+        m_y[s] = y;
+    }
+
+    void setDirection(Slot s, Direction d) { m_direction[s] = d; }
+
+      // Prevent copying or assigning stores; GraphObjects point into them
+    GraphObjectStore(const GraphObjectStore&) = delete;
+    GraphObjectStore& operator=(const GraphObjectStore&) = delete;
+
+  protected:
+      // Adds one slot at the end, or forgets them all
+    void addSlot()
+    {
+        m_x.push_back(0);
+        m_y.push_back(0);
+        m_direction.push_back(0);
+    }
+
+    void clearSlots()
+    {
+        m_x.clear();
+        m_y.clear();
+        m_direction.clear();
+    }
+
+  private:
+    GraphObjectRegistry* m_registry;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<Direction> m_direction;
+};
+
 class GraphObject
 {
   public:
@@ -20,45 +130,48 @@ class GraphObject
     static const int up = 90;
     static const int down = 270;
 
-    GraphObject(int imageID, double startX, double startY, Direction dir = 0, int depth = 0, double size = 1.0)
-     : m_imageID(imageID), m_x(startX), m_y(startY), m_destX(startX), m_destY(startY),
-       m_animationNumber(0), m_direction(dir), m_depth(depth), m_size(size)
+      // store holds the object's position and direction in slot, which
+      // the caller must already have set aside for it; the object is drawn
+      // from store's registry
+    GraphObject(GraphObjectStore* store, GraphObjectStore::Slot slot, int imageID, double startX, double startY, Direction dir = 0, int depth = 0, double size = 1.0)
+     : m_store(store), m_slot(slot), m_imageID(imageID), m_animationNumber(0),
+       m_depth(depth), m_registrySlot(-1), m_size(size)
     {
         if (m_size <= 0)
             m_size = 1;
 
-        getGraphObjects(m_depth).insert(this);
+        m_store->setPosition(m_slot, startX, startY);
+        setDirection(dir);
+        if (m_store->registry() != nullptr)
+            m_store->registry()->add(this);
     }
 
     virtual ~GraphObject()
     {
-        getGraphObjects(m_depth).erase(this);
+        if (m_store->registry() != nullptr)
+            m_store->registry()->remove(this);
     }
 
     double getX() const
     {
-          // If already moved but not yet animated, use new location anyway.
-        return m_destX;
+        return m_store->x(m_slot);
     }
 
     double getY() const
     {
-          // If already moved but not yet animated, use new location anyway.
-        return m_destY;
+        return m_store->y(m_slot);
     }
 
     virtual void moveTo(double x, double y)
     {
-        m_destX = x;
-        m_destY = y;
+        m_store->setPosition(m_slot, x, y);
         increaseAnimationNumber();
     }
 
     virtual void moveAngle(Direction angle, int units = 1)
     {
-    	const double PI = 4 * atan(1);
-    	double newX = (getX() + units * cos(angle*1.0 / 360 * 2 * PI));
-    	double newY = (getY() + units * sin(angle*1.0 / 360 * 2 * PI));
+    	double newX = (getX() + units * Trig::cosDegrees(angle));
+    	double newY = (getY() + units * Trig::sinDegrees(angle));
 
     	moveTo(newX, newY);
     	increaseAnimationNumber();
@@ -66,9 +179,8 @@ class GraphObject
 
     virtual void getPositionInThisDirection(Direction angle, int units, double &dx, double &dy)
     {
-    	const double PI = 4 * atan(1);
-    	dx = (getX() + units * cos(angle*1.0 / 360 * 2 * PI));
-    	dy = (getY() + units * sin(angle*1.0 / 360 * 2 * PI));
+    	dx = (getX() + units * Trig::cosDegrees(angle));
+    	dy = (getY() + units * Trig::sinDegrees(angle));
     }
 
     void moveForward(int units = 1)
@@ -78,7 +190,7 @@ class GraphObject
 
     Direction getDirection() const
     {
-        return m_direction;
+        return m_store->direction(m_slot);
     }
 
     void setDirection(Direction d)
@@ -86,7 +198,7 @@ class GraphObject
         while (d < 0)
             d += 360;
 
-        m_direction = d % 360;
+        m_store->setDirection(m_slot, d % 360);
     }
 
     void setSize(double size)
@@ -107,62 +219,68 @@ class GraphObject
     }
 
     template<typename Func>
-    static void drawAllObjects(Func plotFunc)
+    static void drawAllObjects(const GraphObjectRegistry& registry, Func plotFunc)
     {
-        for (int depth = NUM_DEPTHS - 1; depth >= 0; depth--)
+          // Objects are drawn right where they are; there is no in-between
+          // animation to catch up on.
+        registry.forEach([&](GraphObject* go)
         {
-            for (GraphObject* go : getGraphObjects(depth))
-            {
-                go->animate();
-                plotFunc(go->m_imageID, go->m_animationNumber, go->m_x, go->m_y, go->m_direction, go->m_size);
-            }
-        }
+            plotFunc(go->m_imageID, go->m_animationNumber, go->getX(), go->getY(), go->getDirection(), go->m_size);
+        });
     }
 
       // Prevent copying or assigning GraphObjects
     GraphObject(const GraphObject&) = delete;
     GraphObject& operator=(const GraphObject&) = delete;
 
+  protected:
+      // The store this object's position and direction live in, and its slot
+    GraphObjectStore* store() const { return m_store; }
+    GraphObjectStore::Slot slot() const { return m_slot; }
+
   private:
+    friend class GraphObjectRegistry;
 
-    static const int NUM_DEPTHS = 4;
+    GraphObjectStore* m_store;
+    GraphObjectStore::Slot m_slot;
     int     m_imageID;
-    double  m_x;
-    double  m_y;
-    double  m_destX;
-    double  m_destY;
     int     m_animationNumber;
-    Direction   m_direction;
     int     m_depth;
+    int     m_registrySlot;
     double  m_size;
+};
 
-    void animate()
-    {
-        m_x = m_destX;
-        m_y = m_destY;
-        //moveALittle(m_x, m_destX);
-        //moveALittle(m_y, m_destY);
-    }
+inline void GraphObjectRegistry::add(GraphObject* go)
+{
+    Bucket& bucket = m_buckets[bucketFor(go->m_depth)];
+    go->m_registrySlot = static_cast<int>(bucket.slots.size());
+    bucket.slots.push_back(go);
+}
 
-    void moveALittle(double& from, double& to)
-    {
-        static const double DISTANCE = 1.0/ANIMATION_POSITIONS_PER_TICK;
-        if (to - from >= DISTANCE)
-            from += DISTANCE;
-        else if (from - to >= DISTANCE)
-            from -= DISTANCE;
-        else
-            from = to;
-    }
+inline void GraphObjectRegistry::remove(GraphObject* go)
+{
+    Bucket& bucket = m_buckets[bucketFor(go->m_depth)];
+    bucket.slots[go->m_registrySlot] = nullptr;
+    go->m_registrySlot = -1;
+    bucket.holes++;
+    if (bucket.holes * 2 > bucket.slots.size())
+        compact(bucket);
+}
 
-    static std::set<GraphObject*>& getGraphObjects(int depth)
+inline void GraphObjectRegistry::compact(Bucket& bucket)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < bucket.slots.size(); i++)
     {
-        static std::set<GraphObject*> graphObjects[NUM_DEPTHS];
-        if (depth < NUM_DEPTHS)
-            return graphObjects[depth];
-        else
-            return graphObjects[0];     // empty;
+        GraphObject* go = bucket.slots[i];
+        if (go != nullptr)
+        {
+            go->m_registrySlot = static_cast<int>(kept);
+            bucket.slots[kept++] = go;
+        }
     }
-};
+    bucket.slots.resize(kept);
+    bucket.holes = 0;
+}
 
 #endif // GRAPHOBJ_H_
@@ -0,0 +1,111 @@
+#include "HeadlessController.h"
+#include "GameWorld.h"
+#include "GameConstants.h"
+#include <sstream>
+using namespace std;
+
+static const int NO_KEY = 0;
+
+HeadlessController::HeadlessController()
+ : m_nextKey(0), m_randomPolicy(false), m_ticks(0), m_quit(false), m_gameStatText("")
+{
+}
+
+void HeadlessController::setKeyScript(const vector<int>& keys)
+{
+    m_keys = keys;
+    m_nextKey = 0;
+    m_randomPolicy = false;
+}
+
+void HeadlessController::setRandomPolicy(uint64_t seed)
+{
+    m_policyRng.setSeed(seed);
+    m_randomPolicy = true;
+}
+
+bool HeadlessController::parseKeyScript(string text, vector<int>& keys)
+{
+    istringstream iss(text);
+    string name;
+    keys.clear();
+    while (iss >> name)
+    {
+        if (name == "left")                         keys.push_back(KEY_PRESS_LEFT);
+        else if (name == "right")                   keys.push_back(KEY_PRESS_RIGHT);
+        else if (name == "up")                      keys.push_back(KEY_PRESS_UP);
+        else if (name == "down")                    keys.push_back(KEY_PRESS_DOWN);
+        else if (name == "space")                   keys.push_back(KEY_PRESS_SPACE);
+        else if (name == "enter")                   keys.push_back(KEY_PRESS_ENTER);
+        else if (name == "escape")                  keys.push_back(KEY_PRESS_ESCAPE);
+        else if (name == "tab")                     keys.push_back(KEY_PRESS_TAB);
+        else if (name == "none" || name == ".")     keys.push_back(NO_KEY);
+        else if (name.size() == 1)                  keys.push_back(name[0]);
+        else
+            return false;
+    }
+    return true;
+}
+
+int HeadlessController::runLevel(GameWorld* gw, long maxTicks)
+{
+    int status = gw->init();
+    if (status != GWSTATUS_CONTINUE_GAME)
+        return status;
+
+    for (long t = 0; maxTicks <= 0 || t < maxTicks; t++)
+    {
+        status = gw->move();
+        m_ticks++;
+        if (status != GWSTATUS_CONTINUE_GAME || m_quit)
+            break;
+    }
+
+    if (status == GWSTATUS_FINISHED_LEVEL)
+        gw->advanceToNextLevel();
+    // GameController would prompt for Enter here, with the next level being
+    // prepared in the meantime.
+    if ((status == GWSTATUS_FINISHED_LEVEL || status == GWSTATUS_PLAYER_DIED) && !gw->isGameOver())
+        gw->prepareNextLevel();
+    gw->cleanUp();
+    return status;
+}
+
+bool HeadlessController::getLastKey(int& value)
+{
+    if (m_randomPolicy)
+    {
+        // Mostly idle or spraying, some walking, the odd flame burst.
+        int roll = m_policyRng.randInt(1, 100);
+        if (roll <= 40) return false;
+        else if (roll <= 55) value = KEY_PRESS_LEFT;
+        else if (roll <= 70) value = KEY_PRESS_RIGHT;
+        else if (roll <= 95) value = KEY_PRESS_SPACE;
+        else value = KEY_PRESS_ENTER;
+        return true;
+    }
+
+    if (m_keys.empty())
+        return false;
+
+    int key = m_keys[m_nextKey];
+    m_nextKey = (m_nextKey + 1) % m_keys.size();
+    if (key == NO_KEY)
+        return false;
+    value = key;
+    return true;
+}
+
+void HeadlessController::playSound(int /* soundID */)
+{
+}
+
+void HeadlessController::setGameStatText(const char* text)
+{
+    m_gameStatText = text;
+}
+
+void HeadlessController::quitGame()
+{
+    m_quit = true;
+}
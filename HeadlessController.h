@@ -0,0 +1,65 @@
+#ifndef HEADLESSCONTROLLER_H_
+#define HEADLESSCONTROLLER_H_
+
+#include "WorldController.h"
+#include "RandomGenerator.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GameWorld;
+
+// HeadlessController
+// Runs a GameWorld with no window, no sound and no GLUT. Keys come from a
+// script instead of the keyboard: one entry per tick, looping back to the
+// start when it runs out. An INVALID_KEY entry (0) means "no key this tick".
+class HeadlessController : public WorldController
+{
+  public:
+    HeadlessController();
+
+    // setKeyScript(const std::vector<int>& keys)
+    // Replaces the key script and starts it from the beginning.
+    void setKeyScript(const std::vector<int>& keys);
+
+    // setRandomPolicy(std::uint64_t seed)
+    // Ignores the key script and presses a random key (or nothing) every
+    // tick instead, using its own generator seeded with seed.
+    void setRandomPolicy(std::uint64_t seed);
+
+    // parseKeyScript(std::string text, std::vector<int>& keys)
+    // Turns whitespace-separated key names into a key script. Accepts
+    // left, right, space, enter, escape, none (or .) and single characters.
+    // Returns false if a name isn't recognised.
+    static bool parseKeyScript(std::string text, std::vector<int>& keys);
+
+    // runLevel(GameWorld* gw, long maxTicks)
+    // Calls init(), then move() until the level ends, the game is quit or
+    // maxTicks ticks have passed (maxTicks <= 0 means no limit), then cleanUp().
+    // Returns the last status move() returned, advancing the level on a
+    // finished level the way GameController does. When another level
+    // follows (one was finished, or a life lost with more to spare) it also
+    // calls prepareNextLevel() before cleanUp(), where GameController shows
+    // its prompt, so the next runLevel() picks up the prepared level.
+    int runLevel(GameWorld* gw, long maxTicks);
+
+    long ticks() const { return m_ticks; }
+    bool quitRequested() const { return m_quit; }
+    const char* gameStatText() const { return m_gameStatText; }
+
+    virtual bool getLastKey(int& value);
+    virtual void playSound(int soundID);
+    virtual void setGameStatText(const char* text);
+    virtual void quitGame();
+
+  private:
+    std::vector<int> m_keys;
+    int         m_nextKey;
+    bool        m_randomPolicy;
+    RandomGenerator m_policyRng;
+    long        m_ticks;
+    bool        m_quit;
+    const char* m_gameStatText;
+};
+
+#endif // HEADLESSCONTROLLER_H_
@@ -0,0 +1,64 @@
+#include "HudText.h"
+
+HudText::HudText()
+{
+    for (int i = 0; i < NUM_FIELDS; i++)
+        m_values[i] = 0;
+    m_dirty = true;
+    m_text[0] = '\0';
+    update();
+}
+
+void HudText::set(Field field, int value)
+{
+    if (m_values[field] != value)
+    {
+        m_values[field] = value;
+        m_dirty = true;
+    }
+}
+
+bool HudText::update()
+{
+    if (!m_dirty)
+        return false;
+    m_dirty = false;
+
+    char* out = m_text;
+    appendField(out, "Score: ", m_values[SCORE], 6, '0');
+    appendField(out, "  Level: ", m_values[LEVEL], 2, ' ');
+    appendField(out, "  Lives: ", m_values[LIVES], 2, ' ');
+    appendField(out, "  Health: ", m_values[HEALTH], 3, ' ');
+    appendField(out, "  Sprays: ", m_values[SPRAYS], 2, ' ');
+    appendField(out, "  Flames: ", m_values[FLAMES], 2, ' ');
+    *out = '\0';
+    return true;
+}
+
+const char* HudText::text() const
+{
+    return m_text;
+}
+
+void HudText::appendField(char*& out, const char* label, int value, int width, char fill)
+{
+    while (*label != '\0')
+        *out++ = *label++;
+
+    // Digits come out backwards, so build them in a scratch buffer first.
+    char digits[12];
+    int length = 0;
+    long long magnitude = value < 0 ? -static_cast<long long>(value) : value;
+    do
+    {
+        digits[length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0)
+        digits[length++] = '-';
+
+    for (int i = length; i < width; i++)
+        *out++ = fill;
+    while (length > 0)
+        *out++ = digits[--length];
+}
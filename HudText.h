@@ -0,0 +1,50 @@
+#ifndef HUDTEXT_H_
+#define HUDTEXT_H_
+
+// HudText
+// The status line shown above the dish:
+//   Score: 001234  Level:  3  Lives:  2  Health: 100  Sprays: 20  Flames:  5
+// Each field remembers its last value, and the line is only re-formatted,
+// into a fixed buffer with no heap allocation, when one of them changes.
+// text() stays at the same address for the HudText's lifetime, so it can be
+// handed to a controller once and read from there without copying.
+class HudText
+{
+public:
+    enum Field
+    {
+        SCORE, LEVEL, LIVES, HEALTH, SPRAYS, FLAMES, NUM_FIELDS
+    };
+
+    HudText();
+
+    // set(Field field, int value)
+    // Updates one field, marking the line dirty if the value changed.
+    void set(Field field, int value);
+
+    // update()
+    // Re-formats the line if any field changed since the last update().
+    // Returns true if the text changed.
+    bool update();
+
+    // text()
+    // Returns the line as of the last update().
+    const char* text() const;
+
+    HudText(const HudText&) = delete;
+    HudText& operator=(const HudText&) = delete;
+
+private:
+    static const int MAX_LENGTH = 128;
+
+    int m_values[NUM_FIELDS];
+    bool m_dirty;
+    char m_text[MAX_LENGTH];
+
+    // appendField(char*& out, const char* label, int value, int width, char fill)
+    // Writes label followed by value right-aligned in width characters,
+    // padded on the left with fill (ahead of any minus sign).
+    static void appendField(char*& out, const char* label, int value, int width, char fill);
+};
+
+#endif // HUDTEXT_H_
@@ -0,0 +1,188 @@
+#include "LevelLayout.h"
+#include "GameConstants.h"
+#include "DistanceKernel.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace
+{
+    const DistanceKernel::Radius OVERLAP_RADIUS(SPRITE_WIDTH);
+
+    // SpawnPoints
+    // The whole-pixel points a level item can start at, numbered column by
+    // column so one random index picks one uniformly. These are exactly the
+    // points the old rejection loop would accept.
+    class SpawnPoints
+    {
+    public:
+        static const int FIRST_X = SPRITE_WIDTH;
+        static const int NUM_COLUMNS = VIEW_WIDTH - SPRITE_WIDTH;
+
+        SpawnPoints()
+        {
+            m_total = 0;
+            for (int i = 0; i < NUM_COLUMNS; i++)
+            {
+                double x = FIRST_X + i;
+                m_firstIndex[i] = m_total;
+                m_lowY[i] = 0;
+                int count = 0;
+                for (int y = SPRITE_HEIGHT; y < VIEW_HEIGHT; y++)
+                {
+                    double distance = sqrt(pow(x - VIEW_RADIUS, 2) + pow(y - VIEW_RADIUS, 2));
+                    if (distance > LevelLayout::SPAWN_RADIUS)
+                        continue;
+                    if (count == 0)
+                        m_lowY[i] = y;
+                    count++;
+                }
+                m_total += count;
+            }
+        }
+
+        int size() const
+        {
+            return m_total;
+        }
+
+        LevelLayout::Position at(int index) const
+        {
+            // Last column whose first index is <= index.
+            int column = static_cast<int>(upper_bound(m_firstIndex, m_firstIndex + NUM_COLUMNS, index) - m_firstIndex) - 1;
+            LevelLayout::Position p;
+            p.x = FIRST_X + column;
+            p.y = m_lowY[column] + (index - m_firstIndex[column]);
+            return p;
+        }
+
+    private:
+        int m_firstIndex[NUM_COLUMNS];
+        int m_lowY[NUM_COLUMNS];        // each column's points run from here, unbroken
+        int m_total;
+    };
+
+    // randomSpawnPoint(RandomGenerator& rng)
+    // A uniformly chosen whole-pixel point within SPAWN_RADIUS of the centre.
+    LevelLayout::Position randomSpawnPoint(RandomGenerator& rng)
+    {
+        static const SpawnPoints points;
+        return points.at(rng.randInt(0, points.size() - 1));
+    }
+
+    // SpacingGrid
+    // Positions bucketed by SPRITE_WIDTH cells, so checking a candidate for
+    // overlaps only looks at the 3x3 cells around it.
+    class SpacingGrid
+    {
+    public:
+        static const int CELL_SIZE = SPRITE_WIDTH;
+        static const int CELLS_PER_ROW = VIEW_WIDTH / CELL_SIZE;
+        static const int CELLS_PER_COL = VIEW_HEIGHT / CELL_SIZE;
+
+        SpacingGrid() : m_cells(CELLS_PER_ROW * CELLS_PER_COL) {}
+
+        void add(const LevelLayout::Position& p)
+        {
+            m_cells[row(p.y) * CELLS_PER_ROW + column(p.x)].push_back(p);
+        }
+
+        // isClear(const LevelLayout::Position& p)
+        // Returns true if nothing added so far overlaps p.
+        bool isClear(const LevelLayout::Position& p) const
+        {
+            int r = row(p.y), c = column(p.x);
+            for (int nr = max(r - 1, 0); nr <= min(r + 1, CELLS_PER_COL - 1); nr++)
+            {
+                for (int nc = max(c - 1, 0); nc <= min(c + 1, CELLS_PER_ROW - 1); nc++)
+                {
+                    const vector<LevelLayout::Position>& cell = m_cells[nr * CELLS_PER_ROW + nc];
+                    for (size_t i = 0; i < cell.size(); i++)
+                    {
+                        if (DistanceKernel::within(p.x - cell[i].x, p.y - cell[i].y, OVERLAP_RADIUS))
+                            return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+    private:
+        vector<vector<LevelLayout::Position>> m_cells;
+
+        static int column(double x) { return min(max(static_cast<int>(x) / CELL_SIZE, 0), CELLS_PER_ROW - 1); }
+        static int row(double y) { return min(max(static_cast<int>(y) / CELL_SIZE, 0), CELLS_PER_COL - 1); }
+    };
+
+    // place(int count, RandomGenerator& rng, const SpacingGrid& keepClearOf,
+    //       SpacingGrid* occupied, vector<LevelLayout::Position>& out)
+    // Adds count positions to out that don't overlap keepClearOf, also
+    // recording each in occupied if it is not null. Returns false as soon as
+    // one position runs out of candidates.
+    bool place(int count, RandomGenerator& rng, const SpacingGrid& keepClearOf,
+               SpacingGrid* occupied, vector<LevelLayout::Position>& out)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            bool placed = false;
+            for (int attempt = 0; attempt < LevelLayout::MAX_CANDIDATES && !placed; attempt++)
+            {
+                LevelLayout::Position p = randomSpawnPoint(rng);
+                if (!keepClearOf.isClear(p))
+                    continue;
+                out.push_back(p);
+                if (occupied != nullptr)
+                    occupied->add(p);
+                placed = true;
+            }
+            if (!placed)
+                return false;
+        }
+        return true;
+    }
+}
+
+bool LevelLayout::generate(int level, RandomGenerator& rng)
+{
+    m_pits.clear();
+    m_food.clear();
+    m_dirt.clear();
+
+    // Pits and food keep clear of each other; dirt keeps clear of both.
+    SpacingGrid pitsAndFood;
+    return place(numPits(level), rng, pitsAndFood, &pitsAndFood, m_pits)
+        && place(numFood(level), rng, pitsAndFood, &pitsAndFood, m_food)
+        && place(numDirt(level), rng, pitsAndFood, nullptr, m_dirt);
+}
+
+const vector<LevelLayout::Position>& LevelLayout::pits() const
+{
+    return m_pits;
+}
+
+const vector<LevelLayout::Position>& LevelLayout::food() const
+{
+    return m_food;
+}
+
+const vector<LevelLayout::Position>& LevelLayout::dirt() const
+{
+    return m_dirt;
+}
+
+int LevelLayout::numPits(int /* level */)
+{
+    // The dish has always started with a single pit whatever the level:
+    // the old loop meant to place one per level but kept only the first.
+    return 1;
+}
+
+int LevelLayout::numFood(int level)
+{
+    return min(5*level, 25);
+}
+
+int LevelLayout::numDirt(int level)
+{
+    return max(180-20*level, 20);
+}
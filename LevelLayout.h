@@ -0,0 +1,55 @@
+#ifndef LEVELLAYOUT_H_
+#define LEVELLAYOUT_H_
+
+#include "RandomGenerator.h"
+#include <vector>
+
+// LevelLayout
+// Where a level's pits, food and dirt start, worked out as plain positions
+// before any Actor is created.
+//
+// Candidates are drawn uniformly from the whole-pixel points within
+// SPAWN_RADIUS of the dish centre, one draw per candidate. Pits and food
+// have to keep clear of each other by more than SPRITE_WIDTH, so they are
+// placed by dart throwing (Poisson-disk sampling) against a grid of what has
+// been placed so far; dirt only has to keep clear of pits and food and may
+// pile up on other dirt. Every item gets at most MAX_CANDIDATES draws, so
+// generating a layout always finishes, and fails instead of looping when a
+// dish is too crowded to fit its items.
+class LevelLayout
+{
+public:
+    struct Position
+    {
+        double x;
+        double y;
+    };
+
+    static const int SPAWN_RADIUS = 120;
+    static const int MAX_CANDIDATES = 200;
+
+    // generate(int level, RandomGenerator& rng)
+    // Replaces the layout with a fresh one for level, drawing from rng.
+    // Returns false if some item found no room within its candidates;
+    // the layout is then incomplete and shouldn't be used.
+    bool generate(int level, RandomGenerator& rng);
+
+    // pits() / food() / dirt()
+    // The positions generate() picked, in the order it picked them.
+    const std::vector<Position>& pits() const;
+    const std::vector<Position>& food() const;
+    const std::vector<Position>& dirt() const;
+
+    // numPits(int level) / numFood(int level) / numDirt(int level)
+    // How many of each a level starts with.
+    static int numPits(int level);
+    static int numFood(int level);
+    static int numDirt(int level);
+
+private:
+    std::vector<Position> m_pits;
+    std::vector<Position> m_food;
+    std::vector<Position> m_dirt;
+};
+
+#endif // LEVELLAYOUT_H_
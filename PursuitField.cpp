@@ -0,0 +1,197 @@
+#include "PursuitField.h"
+#include "Trig.h"
+#include <algorithm>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+using namespace std;
+
+namespace
+{
+    const uint64_t ROW = PursuitField::CELLS_PER_ROW == 64
+        ? ~uint64_t(0) : (uint64_t(1) << PursuitField::CELLS_PER_ROW) - 1;
+
+    // Adds the cells on either side of each cell in m.
+    uint64_t widen(uint64_t m)
+    {
+        return (m | (m << 1) | (m >> 1)) & ROW;
+    }
+
+    int lowestBit(uint64_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+}
+
+PursuitField::PursuitField(double obstacleRadius)
+    : m_radius(obstacleRadius + CELL_SIZE / 2.0),
+      m_obstacleCounts(NUM_CELLS, 0),
+      m_covered(CELLS_PER_COL, 0),
+      m_outside(CELLS_PER_COL, 0),
+      m_steps(NUM_CELLS, UNREACHED)
+{
+    // Same test isBacteriumMovementBlockedAt() makes for the dish edge.
+    for (int r = 0; r < CELLS_PER_COL; r++)
+    {
+        for (int c = 0; c < CELLS_PER_ROW; c++)
+        {
+            double distFromCenter = sqrt(pow(VIEW_WIDTH/2 - centreOf(c), 2) + pow(VIEW_HEIGHT/2 - centreOf(r), 2));
+            if (distFromCenter >= VIEW_RADIUS)
+                m_outside[r] |= uint64_t(1) << c;
+        }
+    }
+    m_targetX = -1;
+    m_targetY = -1;
+    m_targetCell = -1;
+    m_stale = true;
+}
+
+void PursuitField::addObstacle(double x, double y)
+{
+    forEachCoveredCell(x, y, [this](int cell) {
+        if (m_obstacleCounts[cell]++ == 0)
+        {
+            m_covered[cell / CELLS_PER_ROW] |= uint64_t(1) << (cell % CELLS_PER_ROW);
+            m_stale = true;
+        }
+    });
+}
+
+void PursuitField::removeObstacle(double x, double y)
+{
+    forEachCoveredCell(x, y, [this](int cell) {
+        if (--m_obstacleCounts[cell] == 0)
+        {
+            m_covered[cell / CELLS_PER_ROW] &= ~(uint64_t(1) << (cell % CELLS_PER_ROW));
+            m_stale = true;
+        }
+    });
+}
+
+void PursuitField::clearObstacles()
+{
+    fill(m_obstacleCounts.begin(), m_obstacleCounts.end(), 0);
+    fill(m_covered.begin(), m_covered.end(), 0);
+    m_stale = true;
+}
+
+void PursuitField::update(double targetX, double targetY)
+{
+    // Checked before writing anything, so once the field is up to date any
+    // number of threads can call this with the same target at once.
+    if (!m_stale && targetX == m_targetX && targetY == m_targetY)
+        return;
+
+    m_targetX = targetX;
+    m_targetY = targetY;
+    int cell = cellOf(targetX, targetY);
+    if (m_stale || cell != m_targetCell)
+    {
+        m_targetCell = cell;
+        m_stale = false;
+        recompute();
+    }
+}
+
+void PursuitField::recompute()
+{
+    uint64_t open[CELLS_PER_COL], reached[CELLS_PER_COL], frontier[CELLS_PER_COL], next[CELLS_PER_COL];
+    for (int r = 0; r < CELLS_PER_COL; r++)
+    {
+        open[r] = ROW & ~(m_outside[r] | m_covered[r]);
+        reached[r] = frontier[r] = 0;
+    }
+    fill(m_steps.begin(), m_steps.end(), UNREACHED);
+
+    // The target's own cell is where the search starts even if it is
+    // blocked; Socrates sits on the rim, outside the dish proper.
+    int targetRow = m_targetCell / CELLS_PER_ROW;
+    reached[targetRow] = frontier[targetRow] = uint64_t(1) << (m_targetCell % CELLS_PER_ROW);
+    m_steps[m_targetCell] = 0;
+
+    // Each pass reaches every open cell one step (diagonals included)
+    // beyond the last. Only rows next to the frontier can gain cells.
+    int low = targetRow, high = targetRow;
+    for (uint16_t step = 1; low <= high; step++)
+    {
+        int from = max(low - 1, 0), to = min(high + 1, CELLS_PER_COL - 1);
+        uint64_t wide[CELLS_PER_COL + 2] = {};
+        for (int r = low; r <= high; r++)
+            wide[r + 1] = widen(frontier[r]);
+        for (int r = from; r <= to; r++)
+            next[r] = (wide[r] | wide[r + 1] | wide[r + 2]) & open[r] & ~reached[r];
+
+        low = CELLS_PER_COL;
+        high = -1;
+        for (int r = from; r <= to; r++)
+        {
+            frontier[r] = next[r];
+            if (next[r] == 0)
+                continue;
+            reached[r] |= next[r];
+            low = min(low, r);
+            high = r;
+            for (uint64_t bits = next[r]; bits != 0; bits &= bits - 1)
+                m_steps[r * CELLS_PER_ROW + lowestBit(bits)] = step;
+        }
+    }
+}
+
+bool PursuitField::angleFrom(double x, double y, int& angle) const
+{
+    int cell = cellOf(x, y);
+    uint16_t here = m_steps[cell];
+    if (here == 0)
+        return false;
+
+    // From a blocked cell (right next to dirt, or at the rim) any reachable
+    // neighbour is a way back onto the field.
+    int row = cell / CELLS_PER_ROW, col = cell % CELLS_PER_ROW;
+    double toTargetX = m_targetX - x, toTargetY = m_targetY - y;
+    int best = -1;
+    uint16_t bestSteps = here;
+    double bestAlignment = 0;
+    for (int r = max(row - 1, 0); r <= min(row + 1, CELLS_PER_COL - 1); r++)
+    {
+        for (int c = max(col - 1, 0); c <= min(col + 1, CELLS_PER_ROW - 1); c++)
+        {
+            uint16_t steps = m_steps[r * CELLS_PER_ROW + c];
+            if (steps >= here || steps > bestSteps)
+                continue;
+            double dx = centreOf(c) - x, dy = centreOf(r) - y;
+            double length = sqrt(dx * dx + dy * dy);
+            if (length == 0)
+                continue;
+            double alignment = (dx * toTargetX + dy * toTargetY) / length;
+            if (best == -1 || steps < bestSteps || alignment > bestAlignment)
+            {
+                best = r * CELLS_PER_ROW + c;
+                bestSteps = steps;
+                bestAlignment = alignment;
+            }
+        }
+    }
+    if (best == -1)
+        return false;
+
+    angle = Trig::atan2Degrees(centreOf(best / CELLS_PER_ROW) - y, centreOf(best % CELLS_PER_ROW) - x);
+    return true;
+}
+
+int PursuitField::clampCell(double v, int numCells)
+{
+    int i = static_cast<int>(floor(v / CELL_SIZE));
+    return min(max(i, 0), numCells - 1);
+}
+
+int PursuitField::cellOf(double x, double y)
+{
+    return clampCell(y, CELLS_PER_COL) * CELLS_PER_ROW + clampCell(x, CELLS_PER_ROW);
+}
@@ -0,0 +1,97 @@
+#ifndef PURSUITFIELD_H_
+#define PURSUITFIELD_H_
+
+#include "GameConstants.h"
+#include "DistanceKernel.h"
+#include <cstdint>
+#include <vector>
+
+// PursuitField
+// Distance field over a coarse grid of the dish, measured in steps from one
+// target cell (Socrates') and routed around obstacles (Dirt). Bacteria that
+// chase the target look up which way to head instead of steering straight
+// at it and feeling their way around whatever is in between.
+//
+// A cell counts as blocked while its centre is outside the dish or within
+// the obstacle radius plus half a cell of an obstacle; without that margin
+// the way from one open cell centre to the next can clip an obstacle. Cells
+// are SPRITE_WIDTH wide, so the field is only a guide: it says where to go,
+// and movement is still checked against the exact positions.
+class PursuitField
+{
+public:
+    static const int CELL_SIZE = SPRITE_WIDTH;
+    static const int CELLS_PER_ROW = VIEW_WIDTH / CELL_SIZE;
+    static const int CELLS_PER_COL = VIEW_HEIGHT / CELL_SIZE;
+    static const int NUM_CELLS = CELLS_PER_ROW * CELLS_PER_COL;
+    static_assert(CELLS_PER_ROW <= 64, "a row of cells has to fit in one mask");
+
+    // PursuitField(double obstacleRadius)
+    // obstacleRadius is how far from an obstacle's centre movement is blocked.
+    explicit PursuitField(double obstacleRadius);
+
+    // addObstacle(double x, double y) / removeObstacle(double x, double y)
+    // Blocks or unblocks the cells around an obstacle at (x,y). Every
+    // removeObstacle must match an earlier addObstacle at the same spot.
+    void addObstacle(double x, double y);
+    void removeObstacle(double x, double y);
+
+    // clearObstacles()
+    // Removes every obstacle.
+    void clearObstacles();
+
+    // update(double targetX, double targetY)
+    // Makes the field lead to (targetX, targetY). The distances are only
+    // recomputed if the target changed cell or an obstacle changed.
+    void update(double targetX, double targetY);
+
+    // angleFrom(double x, double y, int& angle)
+    // Sets angle to the direction to head from (x,y): toward the
+    // neighbouring cell closest to the target, preferring the one most in
+    // line with the target. Returns false if (x,y) is in the target's cell
+    // or has no route to it; then the caller should head straight there.
+    bool angleFrom(double x, double y, int& angle) const;
+
+    PursuitField(const PursuitField&) = delete;
+    PursuitField& operator=(const PursuitField&) = delete;
+
+private:
+    static constexpr std::uint16_t UNREACHED = 0xFFFF;
+
+    DistanceKernel::Radius m_radius;        // obstacle radius plus the margin
+    std::vector<int> m_obstacleCounts;      // obstacles covering each cell's centre
+    std::vector<std::uint64_t> m_covered;   // per row, cells with a nonzero count
+    std::vector<std::uint64_t> m_outside;   // per row, cells whose centre is off the dish
+    std::vector<std::uint16_t> m_steps;     // steps from each cell to the target cell
+    double m_targetX;
+    double m_targetY;
+    int m_targetCell;
+    bool m_stale;
+
+    static int clampCell(double v, int numCells);
+    static int cellOf(double x, double y);
+    static double centreOf(int index) { return (index + 0.5) * CELL_SIZE; }
+
+    // forEachCoveredCell(double x, double y, Func f)
+    // Calls f(cell) for every cell whose centre is within m_radius of (x,y).
+    template<typename Func>
+    void forEachCoveredCell(double x, double y, Func f) const
+    {
+        int minCol = clampCell(x - m_radius.value, CELLS_PER_ROW), maxCol = clampCell(x + m_radius.value, CELLS_PER_ROW);
+        int minRow = clampCell(y - m_radius.value, CELLS_PER_COL), maxRow = clampCell(y + m_radius.value, CELLS_PER_COL);
+        for (int r = minRow; r <= maxRow; r++)
+        {
+            for (int c = minCol; c <= maxCol; c++)
+            {
+                if (DistanceKernel::within(centreOf(c) - x, centreOf(r) - y, m_radius))
+                    f(r * CELLS_PER_ROW + c);
+            }
+        }
+    }
+
+    // recompute()
+    // Breadth-first search from the target cell, one row mask at a time.
+    void recompute();
+};
+
+#endif // PURSUITFIELD_H_
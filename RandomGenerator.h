@@ -0,0 +1,142 @@
+#ifndef RANDOMGENERATOR_H_
+#define RANDOMGENERATOR_H_
+
+#include <cstdint>
+#include <utility>
+
+  // Unbiased value in [0, range) using a multiply and, almost always,
+  // no division (Lemire's method). next32() supplies 32 random bits.
+  // A range of 0 means the full 2^32.
+template<typename Source>
+inline std::uint32_t boundedRandom(std::uint32_t range, Source next32)
+{
+    std::uint32_t x = next32();
+    if (range == 0)
+        return x;
+    std::uint64_t m = static_cast<std::uint64_t>(x) * range;
+    std::uint32_t low = static_cast<std::uint32_t>(m);
+    if (low < range)
+    {
+        std::uint32_t threshold = (0u - range) % range;
+        while (low < threshold)
+        {
+            x = next32();
+            m = static_cast<std::uint64_t>(x) * range;
+            low = static_cast<std::uint32_t>(m);
+        }
+    }
+    return static_cast<std::uint32_t>(m >> 32);
+}
+
+  // Turns min..max (in either order) into a base and a range for boundedRandom().
+inline std::uint32_t randomRange(int& min, int& max)
+{
+    if (max < min)
+        std::swap(max, min);
+    return static_cast<std::uint32_t>(static_cast<std::int64_t>(max) - min + 1);
+}
+
+// RandomGenerator
+// Small, fast, seedable generator (xoshiro256**, seeded through splitmix64).
+// Each StudentWorld owns one, so two worlds never share hidden state and two
+// runs with the same seed and the same key presses play out identically.
+class RandomGenerator
+{
+  public:
+    explicit RandomGenerator(std::uint64_t seed = 0)
+    {
+        setSeed(seed);
+    }
+
+    void setSeed(std::uint64_t seed)
+    {
+        for (int i = 0; i < 4; i++)
+            m_state[i] = splitMix64(seed);
+    }
+
+      // Return a uniformly distributed random int from min to max, inclusive
+    int randInt(int min, int max)
+    {
+        std::uint32_t range = randomRange(min, max);
+        std::uint32_t offset = boundedRandom(range, [this]() { return static_cast<std::uint32_t>(next64() >> 32); });
+        return static_cast<int>(static_cast<std::int64_t>(min) + offset);
+    }
+
+      // The generator's whole state, for saving and restoring it exactly
+    void getState(std::uint64_t state[4]) const
+    {
+        for (int i = 0; i < 4; i++)
+            state[i] = m_state[i];
+    }
+
+    void setState(const std::uint64_t state[4])
+    {
+        for (int i = 0; i < 4; i++)
+            m_state[i] = state[i];
+    }
+
+    std::uint64_t next64()
+    {
+        const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+        const std::uint64_t t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+      // Advances x and returns the next splitmix64 output. Also used as a
+      // cheap, well-mixed hash step.
+    static std::uint64_t splitMix64(std::uint64_t& x)
+    {
+        std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+  private:
+    std::uint64_t m_state[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// CounterRandom
+// Stateless, counter-based random numbers: each value is a hash of
+// (seed, stream, counter, index), so it doesn't matter who else drew numbers
+// first. StudentWorld uses the actor ID as the stream and the tick as the
+// counter, which lets actors be updated in any order or in parallel
+// without changing what any of them rolls.
+class CounterRandom
+{
+  public:
+    static std::uint64_t at(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter, std::uint64_t index)
+    {
+        std::uint64_t x = seed;
+        std::uint64_t h = RandomGenerator::splitMix64(x);
+        x = h ^ stream;
+        h = RandomGenerator::splitMix64(x);
+        x = h ^ counter;
+        h = RandomGenerator::splitMix64(x);
+        x = h ^ index;
+        return RandomGenerator::splitMix64(x);
+    }
+
+      // Return a uniformly distributed random int from min to max, inclusive.
+      // index is the next unused draw in this (stream, counter); it is advanced
+      // past every value used, including any that had to be rejected.
+    static int randInt(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter, std::uint32_t& index, int min, int max)
+    {
+        std::uint32_t range = randomRange(min, max);
+        std::uint32_t offset = boundedRandom(range, [&]() { return static_cast<std::uint32_t>(at(seed, stream, counter, index++) >> 32); });
+        return static_cast<int>(static_cast<std::int64_t>(min) + offset);
+    }
+};
+
+#endif // RANDOMGENERATOR_H_
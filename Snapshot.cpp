@@ -0,0 +1,120 @@
+#include "Snapshot.h"
+#include <climits>
+#include <cstring>
+using namespace std;
+
+SnapshotWriter::SnapshotWriter(vector<uint8_t>& out)
+    : m_out(out)
+{
+}
+
+void SnapshotWriter::writeLong(long long value)
+{
+    // Zigzag first, so small negative numbers stay short too.
+    uint64_t v = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (v >= 0x80)
+    {
+        m_out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    m_out.push_back(static_cast<uint8_t>(v));
+}
+
+void SnapshotWriter::writeInt(int value)
+{
+    writeLong(value);
+}
+
+void SnapshotWriter::writeUInt64(uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        m_out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void SnapshotWriter::writeDouble(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    writeUInt64(bits);
+}
+
+SnapshotReader::SnapshotReader(const uint8_t* data, size_t size)
+    : m_data(data), m_size(size), m_pos(0), m_ok(true)
+{
+}
+
+long long SnapshotReader::readLong()
+{
+    uint64_t v = 0;
+    for (int shift = 0; m_ok; shift += 7)
+    {
+        if (m_pos == m_size || shift > 63)
+        {
+            m_ok = false;
+            break;
+        }
+        uint8_t byte = m_data[m_pos++];
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return static_cast<long long>((v >> 1) ^ (0 - (v & 1)));
+    }
+    return 0;
+}
+
+uint64_t SnapshotReader::readUInt64()
+{
+    if (!m_ok || m_size - m_pos < 8)
+    {
+        m_ok = false;
+        return 0;
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= static_cast<uint64_t>(m_data[m_pos++]) << (8 * i);
+    return value;
+}
+
+double SnapshotReader::readDouble()
+{
+    uint64_t bits = readUInt64();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int SnapshotReader::readInt()
+{
+    return readInt(INT_MIN, INT_MAX);
+}
+
+int SnapshotReader::readInt(int min, int max)
+{
+    long long value = readLong();
+    if (value < min || value > max)
+    {
+        m_ok = false;
+        return 0;
+    }
+    return static_cast<int>(value);
+}
+
+bool SnapshotReader::ok() const
+{
+    return m_ok;
+}
+
+bool SnapshotReader::atEnd() const
+{
+    return m_pos == m_size;
+}
+
+uint64_t snapshotChecksum(const uint8_t* data, size_t size)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
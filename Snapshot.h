@@ -0,0 +1,66 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// SnapshotWriter / SnapshotReader
+// The byte encoding behind StudentWorld::saveSnapshot() and
+// restoreSnapshot(). Whole numbers are zigzag varints, so the small counts
+// and hit points most fields hold take a byte or two; positions are the
+// exact 8 bytes of the double, little-endian on every platform.
+class SnapshotWriter
+{
+public:
+    // SnapshotWriter(std::vector<std::uint8_t>& out)
+    // Appends to out.
+    explicit SnapshotWriter(std::vector<std::uint8_t>& out);
+
+    void writeLong(long long value);
+    void writeInt(int value);
+    void writeUInt64(std::uint64_t value);
+    void writeDouble(double value);
+
+private:
+    std::vector<std::uint8_t>& m_out;
+};
+
+class SnapshotReader
+{
+public:
+    // SnapshotReader(const std::uint8_t* data, std::size_t size)
+    // Reads from the size bytes at data, which have to outlive the reader.
+    SnapshotReader(const std::uint8_t* data, std::size_t size);
+
+    // Reading past the end, or a value that doesn't fit, returns 0 and
+    // marks the reader failed; everything after that returns 0 too.
+    long long readLong();
+    int readInt();
+    std::uint64_t readUInt64();
+    double readDouble();
+
+    // readInt(int min, int max)
+    // readInt(), failing the reader if the value is outside [min, max].
+    int readInt(int min, int max);
+
+    // ok()
+    // Returns false once any read has failed.
+    bool ok() const;
+
+    // atEnd()
+    // Returns true if every byte has been read.
+    bool atEnd() const;
+
+private:
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_pos;
+    bool m_ok;
+};
+
+// snapshotChecksum(const std::uint8_t* data, std::size_t size)
+// 64-bit FNV-1a over the bytes.
+std::uint64_t snapshotChecksum(const std::uint8_t* data, std::size_t size);
+
+#endif // SNAPSHOT_H_
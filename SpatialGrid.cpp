@@ -0,0 +1,226 @@
+#include "SpatialGrid.h"
+#include "Actor.h"
+
+SpatialGrid::SpatialGrid()
+: m_xs(NUM_CELLS * CELL_CAPACITY), m_ys(NUM_CELLS * CELL_CAPACITY), m_ids(NUM_CELLS * CELL_CAPACITY),
+  m_actors(NUM_CELLS * CELL_CAPACITY), m_counts(NUM_CELLS, 0), m_rowMasks(CELLS_PER_COL, 0),
+  m_overflow(NUM_CELLS)
+{
+    m_occupiedRows = 0;
+}
+
+void SpatialGrid::insert(Actor* actor)
+{
+    addToCell(actor, cellOf(actor->getX(), actor->getY()));
+}
+
+void SpatialGrid::remove(Actor* actor)
+{
+    if (actor->getGridCell() < 0) return;
+    removeFromCell(actor, actor->getGridCell());
+    actor->setGridCell(-1);
+    actor->setGridSlot(-1);
+}
+
+void SpatialGrid::update(Actor* actor)
+{
+    int oldCell = actor->getGridCell();
+    if (oldCell < 0) return;
+
+    int newCell = cellOf(actor->getX(), actor->getY());
+    if (newCell == oldCell)
+    {
+        setPosition(oldCell, actor->getGridSlot(), actor->getX(), actor->getY());
+        return;
+    }
+
+    removeFromCell(actor, oldCell);
+    addToCell(actor, newCell);
+}
+
+void SpatialGrid::clear()
+{
+    for (int i = 0; i < NUM_CELLS; i++)
+    {
+        m_counts[i] = 0;
+        m_overflow[i].xs.clear();
+        m_overflow[i].ys.clear();
+        m_overflow[i].ids.clear();
+        m_overflow[i].actors.clear();
+    }
+    for (int r = 0; r < CELLS_PER_COL; r++)
+        m_rowMasks[r] = 0;
+    m_occupiedRows = 0;
+}
+
+bool SpatialGrid::anyWithin(double x, double y, const DistanceKernel::Radius& radius) const
+{
+    bool found = false;
+    forEachSegment(x, y, radius.value, [&](const double* xs, const double* ys, const int*, Actor* const*, int n)
+    {
+        found = DistanceKernel::hitMask(xs, ys, n, x, y, radius) != 0;
+        return found;
+    });
+    return found;
+}
+
+Actor* SpatialGrid::nearestWithin(double x, double y, double radius) const
+{
+    double bestDistance = radius;
+    int bestID = -1;
+    Actor* best = nullptr;
+    auto fold = [&](const double* xs, const double* ys, const int* ids, Actor* const* actors, int n)
+    {
+        int i = DistanceKernel::nearest(xs, ys, ids, n, x, y, bestDistance, bestID);
+        if (i >= 0)
+            best = actors[i];
+        return false;
+    };
+
+    // Ring k is the border of the (2k+1)-cell square around (x,y)'s cell,
+    // clipped to the cells a point closer than radius could be bucketed in.
+    if (m_occupiedRows == 0)
+        return nullptr;
+    int centerCol = column(x), centerRow = row(y);
+    int limitMinCol = column(x - radius), limitMaxCol = column(x + radius);
+    int limitMinRow = row(y - radius), limitMaxRow = row(y + radius);
+    for (int k = 0; ; k++)
+    {
+        int minCol = centerCol - k, maxCol = centerCol + k;
+        int minRow = centerRow - k, maxRow = centerRow + k;
+        int loCol = std::max(minCol, limitMinCol), hiCol = std::min(maxCol, limitMaxCol);
+        if (loCol <= hiCol)
+        {
+            std::uint64_t span = bitRange(loCol, hiCol);
+            if (minRow >= limitMinRow)
+            {
+                for (std::uint64_t bits = m_rowMasks[minRow] & span; bits != 0; bits &= bits - 1)
+                    forEachSegmentInCell(minRow * CELLS_PER_ROW + lowestBit(bits), fold);
+            }
+            if (k > 0 && maxRow <= limitMaxRow)
+            {
+                for (std::uint64_t bits = m_rowMasks[maxRow] & span; bits != 0; bits &= bits - 1)
+                    forEachSegmentInCell(maxRow * CELLS_PER_ROW + lowestBit(bits), fold);
+            }
+        }
+        if (k > 0)
+        {
+            std::uint64_t sides = 0;
+            if (minCol >= limitMinCol) sides |= std::uint64_t(1) << minCol;
+            if (maxCol <= limitMaxCol) sides |= std::uint64_t(1) << maxCol;
+            std::uint64_t rows = m_occupiedRows & bitRange(std::max(minRow + 1, limitMinRow), std::min(maxRow - 1, limitMaxRow));
+            for ( ; sides != 0 && rows != 0; rows &= rows - 1)
+            {
+                int r = lowestBit(rows);
+                for (std::uint64_t bits = m_rowMasks[r] & sides; bits != 0; bits &= bits - 1)
+                    forEachSegmentInCell(r * CELLS_PER_ROW + lowestBit(bits), fold);
+            }
+        }
+
+        // Anything not searched yet lies past one of the square's edges that
+        // still has cells beyond it, so it is at least that far away.
+        // (A computed distance is never below the gap along one axis.)
+        bool more = false;
+        double bound = radius;
+        if (minCol > limitMinCol) { more = true; bound = std::min(bound, x - minCol * CELL_SIZE); }
+        if (maxCol < limitMaxCol) { more = true; bound = std::min(bound, (maxCol + 1) * CELL_SIZE - x); }
+        if (minRow > limitMinRow) { more = true; bound = std::min(bound, y - minRow * CELL_SIZE); }
+        if (maxRow < limitMaxRow) { more = true; bound = std::min(bound, (maxRow + 1) * CELL_SIZE - y); }
+        if (!more || bound > bestDistance)
+            break;
+    }
+    return best;
+}
+
+void SpatialGrid::addToCell(Actor* actor, int cell)
+{
+    int slot = m_counts[cell]++;
+    if (slot == 0)
+    {
+        m_rowMasks[cell / CELLS_PER_ROW] |= std::uint64_t(1) << (cell % CELLS_PER_ROW);
+        m_occupiedRows |= std::uint64_t(1) << (cell / CELLS_PER_ROW);
+    }
+    actor->setGridCell(cell);
+    actor->setGridSlot(slot);
+    if (slot < CELL_CAPACITY)
+    {
+        int i = cell * CELL_CAPACITY + slot;
+        m_xs[i] = actor->getX();
+        m_ys[i] = actor->getY();
+        m_ids[i] = actor->getID();
+        m_actors[i] = actor;
+    }
+    else
+    {
+        Overflow& more = m_overflow[cell];
+        more.xs.push_back(actor->getX());
+        more.ys.push_back(actor->getY());
+        more.ids.push_back(actor->getID());
+        more.actors.push_back(actor);
+    }
+}
+
+void SpatialGrid::removeFromCell(Actor* actor, int cell)
+{
+    // Order inside a cell doesn't matter, so move the last slot into the hole.
+    int slot = actor->getGridSlot();
+    int last = --m_counts[cell];
+    if (last == 0)
+    {
+        std::uint64_t& rowMask = m_rowMasks[cell / CELLS_PER_ROW];
+        rowMask &= ~(std::uint64_t(1) << (cell % CELLS_PER_ROW));
+        if (rowMask == 0)
+            m_occupiedRows &= ~(std::uint64_t(1) << (cell / CELLS_PER_ROW));
+    }
+    Overflow& more = m_overflow[cell];
+    if (slot != last)
+    {
+        int from = cell * CELL_CAPACITY + last;
+        int to = cell * CELL_CAPACITY + slot;
+        Actor* moved;
+        if (last < CELL_CAPACITY)
+        {
+            m_xs[to] = m_xs[from];
+            m_ys[to] = m_ys[from];
+            m_ids[to] = m_ids[from];
+            moved = m_actors[to] = m_actors[from];
+        }
+        else if (slot < CELL_CAPACITY)
+        {
+            m_xs[to] = more.xs.back();
+            m_ys[to] = more.ys.back();
+            m_ids[to] = more.ids.back();
+            moved = m_actors[to] = more.actors.back();
+        }
+        else
+        {
+            int o = slot - CELL_CAPACITY;
+            more.xs[o] = more.xs.back();
+            more.ys[o] = more.ys.back();
+            more.ids[o] = more.ids.back();
+            moved = more.actors[o] = more.actors.back();
+        }
+        moved->setGridSlot(slot);
+    }
+    if (last >= CELL_CAPACITY)
+    {
+        more.xs.pop_back();
+        more.ys.pop_back();
+        more.ids.pop_back();
+        more.actors.pop_back();
+    }
+}
+
+void SpatialGrid::setPosition(int cell, int slot, double x, double y)
+{
+    if (slot < CELL_CAPACITY)
+    {
+        m_xs[cell * CELL_CAPACITY + slot] = x;
+        m_ys[cell * CELL_CAPACITY + slot] = y;
+    }
+    else
+    {
+        m_overflow[cell].xs[slot - CELL_CAPACITY] = x;
+        m_overflow[cell].ys[slot - CELL_CAPACITY] = y;
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef SPATIALGRID_H_
+#define SPATIALGRID_H_
+
+#include "GameConstants.h"
+#include "DistanceKernel.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class Actor;
+
+// SpatialGrid
+// Uniform grid over the VIEW_WIDTH x VIEW_HEIGHT dish used as a broad phase
+// for StudentWorld's proximity queries. Each cell is SPRITE_WIDTH pixels wide,
+// so an overlap query only has to visit the 3x3 block of cells around a point.
+// Positions outside the dish (e.g. projectiles that flew past the edge) are
+// clamped into the border cells.
+// Each cell mirrors its actors' positions and IDs in contiguous arrays (the
+// first CELL_CAPACITY in grid-wide flat arrays, any beyond that in the cell's
+// overflow arrays), so the narrow phase can run DistanceKernel over a whole
+// cell at once instead of calling getX()/getY() on one actor at a time.
+class SpatialGrid
+{
+public:
+    static const int CELL_SIZE = SPRITE_WIDTH;
+    static const int CELLS_PER_ROW = VIEW_WIDTH / CELL_SIZE;
+    static const int CELLS_PER_COL = VIEW_HEIGHT / CELL_SIZE;
+    static const int NUM_CELLS = CELLS_PER_ROW * CELLS_PER_COL;
+    static constexpr int CELL_CAPACITY = 8;
+    static_assert(CELLS_PER_ROW <= 64 && CELLS_PER_COL <= 64, "occupancy masks are 64 bits");
+
+    SpatialGrid();
+
+    // insert(Actor* actor)
+    // Buckets actor by its current position.
+    void insert(Actor* actor);
+
+    // remove(Actor* actor)
+    // Takes actor out of the cell it was last bucketed in.
+    void remove(Actor* actor);
+
+    // update(Actor* actor)
+    // Re-buckets actor if its position moved it into another cell, and
+    // refreshes its mirrored position either way.
+    // Actors that were never inserted are ignored.
+    void update(Actor* actor);
+
+    // clear()
+    // Empties every cell. Does not delete the actors.
+    void clear();
+
+    // forEachNear(double x, double y, double radius, Func f)
+    // Calls f(Actor*) for every actor bucketed in a cell that intersects the
+    // square of half-width radius around (x,y). The caller still has to do
+    // the exact distance test; cell order is not insertion order.
+    template<typename Func>
+    void forEachNear(double x, double y, double radius, Func f) const
+    {
+        forEachSegment(x, y, radius, [&](const double*, const double*, const int*, Actor* const* actors, int n)
+        {
+            for (int i = 0; i < n; i++)
+                f(actors[i]);
+            return false;
+        });
+    }
+
+    // forEachWithin(double x, double y, const DistanceKernel::Radius& radius, Func f)
+    // Calls f(Actor*) for every actor whose position is within radius of (x,y).
+    // Cell order is not insertion order.
+    template<typename Func>
+    void forEachWithin(double x, double y, const DistanceKernel::Radius& radius, Func f) const
+    {
+        forEachSegment(x, y, radius.value, [&](const double* xs, const double* ys, const int*, Actor* const* actors, int n)
+        {
+            std::uint64_t hits = DistanceKernel::hitMask(xs, ys, n, x, y, radius);
+            for (int i = 0; hits != 0; i++, hits >>= 1)
+            {
+                if (hits & 1)
+                    f(actors[i]);
+            }
+            return false;
+        });
+    }
+
+    // anyWithin(double x, double y, const DistanceKernel::Radius& radius)
+    // Returns true if any actor's position is within radius of (x,y).
+    bool anyWithin(double x, double y, const DistanceKernel::Radius& radius) const;
+
+    // nearestWithin(double x, double y, double radius)
+    // Returns the actor closest to (x,y) that is strictly less than radius
+    // away, with ties going to the lowest ID, or nullptr if there is none.
+    // Searches rings of cells outward from (x,y)'s cell and stops as soon as
+    // nothing outside the rings searched so far could be closer, so a
+    // nearby match is found without visiting the whole radius.
+    Actor* nearestWithin(double x, double y, double radius) const;
+
+    SpatialGrid(const SpatialGrid&) = delete;
+    SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+private:
+    // Slots CELL_CAPACITY and up of a crowded cell; the four arrays are kept in step.
+    struct Overflow
+    {
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::vector<int> ids;
+        std::vector<Actor*> actors;
+    };
+
+    // Slot s < CELL_CAPACITY of cell c lives at [c * CELL_CAPACITY + s].
+    std::vector<double> m_xs;
+    std::vector<double> m_ys;
+    std::vector<int> m_ids;
+    std::vector<Actor*> m_actors;
+    std::vector<int> m_counts;
+    std::vector<std::uint64_t> m_rowMasks;    // bit c of row r set while cell (r,c) is non-empty
+    std::uint64_t m_occupiedRows;             // bit r set while row r has a non-empty cell
+    std::vector<Overflow> m_overflow;
+
+    static int clampCell(double v, int numCells)
+    {
+        int cell = static_cast<int>(std::floor(v / CELL_SIZE));
+        if (cell < 0) return 0;
+        if (cell >= numCells) return numCells - 1;
+        return cell;
+    }
+
+    static int column(double x) { return clampCell(x, CELLS_PER_ROW); }
+    static int row(double y) { return clampCell(y, CELLS_PER_COL); }
+    static int cellOf(double x, double y) { return row(y) * CELLS_PER_ROW + column(x); }
+
+    // forEachSegment(double x, double y, double radius, Func f)
+    // Calls f(xs, ys, ids, actors, n) for each contiguous run of at most
+    // DistanceKernel::MAX_BATCH actors in the cells forEachNear visits,
+    // stopping early if f returns true.
+    template<typename Func>
+    void forEachSegment(double x, double y, double radius, Func f) const
+    {
+        int minCol = column(x - radius), maxCol = column(x + radius);
+        int minRow = row(y - radius), maxRow = row(y + radius);
+        for (std::uint64_t rows = m_occupiedRows & bitRange(minRow, maxRow); rows != 0; rows &= rows - 1)
+        {
+            int r = lowestBit(rows);
+            std::uint64_t occupied = m_rowMasks[r] & bitRange(minCol, maxCol);
+            for ( ; occupied != 0; occupied &= occupied - 1)
+            {
+                if (forEachSegmentInCell(r * CELLS_PER_ROW + lowestBit(occupied), f))
+                    return;
+            }
+        }
+    }
+
+    // forEachSegmentInCell(int cell, Func f)
+    // Same, for one cell. Returns true if f stopped it.
+    template<typename Func>
+    bool forEachSegmentInCell(int cell, Func f) const
+    {
+        int count = m_counts[cell];
+        if (count == 0)
+            return false;
+        int base = cell * CELL_CAPACITY;
+        if (f(&m_xs[base], &m_ys[base], &m_ids[base], &m_actors[base], std::min(count, CELL_CAPACITY)))
+            return true;
+        const Overflow& more = m_overflow[cell];
+        for (int i = 0; i < count - CELL_CAPACITY; i += DistanceKernel::MAX_BATCH)
+        {
+            int n = std::min(count - CELL_CAPACITY - i, DistanceKernel::MAX_BATCH);
+            if (f(&more.xs[i], &more.ys[i], &more.ids[i], &more.actors[i], n))
+                return true;
+        }
+        return false;
+    }
+
+    // bitRange(int lo, int hi)
+    // Bits lo through hi of an occupancy mask; none if lo > hi.
+    static std::uint64_t bitRange(int lo, int hi)
+    {
+        if (lo > hi)
+            return 0;
+        std::uint64_t upTo = hi >= 63 ? ~std::uint64_t(0) : (std::uint64_t(1) << (hi + 1)) - 1;
+        return upTo & ~((std::uint64_t(1) << lo) - 1);
+    }
+
+    static int lowestBit(std::uint64_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    void addToCell(Actor* actor, int cell);
+    void removeFromCell(Actor* actor, int cell);
+    void setPosition(int cell, int slot, double x, double y);
+};
+
+#endif // SPATIALGRID_H_
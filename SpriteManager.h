@@ -12,6 +12,8 @@
 #endif
 
 #include "GameConstants.h"
+#include "Trace.h"
+#include "Trig.h"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -37,6 +39,7 @@ public:
 
     bool loadSprite(std::string filename_tga, int imageID, int frameNum)
     {
+        TRACE_ZONE("loadSprite");
           // Load Texture Data From TGA File
 
         int spriteID = getSpriteID(imageID, frameNum);
@@ -171,7 +174,7 @@ public:
 
           // Rotate sprite.  For 180 degrees, don't rotate, but reflect
         double rx1, ry1, rx2, ry2, rx3, ry3, rx4, ry4;
-        double rotationAngle = (angleDegrees == 180 ? 0 : angleDegrees);
+        int rotationAngle = (angleDegrees == 180 ? 0 : angleDegrees);
         rotate(-finalWidth / 2, -finalHeight / 2, rotationAngle, rx1, ry1);
         rotate( finalWidth / 2, -finalHeight / 2, rotationAngle, rx2, ry2);
         rotate( finalWidth / 2,  finalHeight / 2, rotationAngle, rx3, ry3);
@@ -241,12 +244,11 @@ private:
         return imageID * MAX_FRAMES_PER_SPRITE + frame;
     }
 
-    static void rotate(double x, double y, double degrees, double &xout, double &yout)
+    static void rotate(double x, double y, int degrees, double &xout, double &yout)
     {
-        static const double PI = 4 * atan(1.0);
-        double theta = degrees * (2 * PI / 360);
-        xout = x * cos(theta) - y * sin(theta);
-        yout = y * cos(theta) + x * sin(theta);
+        double c = Trig::cosDegrees(degrees), s = Trig::sinDegrees(degrees);
+        xout = x * c - y * s;
+        yout = y * c + x * s;
     }
 
     static void convertToGlutCoords(double x, double y, double& gx, double& gy, double& gz)
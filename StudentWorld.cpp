@@ -1,12 +1,23 @@
 #include "Actor.h"
 #include "StudentWorld.h"
 #include "GameConstants.h"
+#include "Trace.h"
+#include "Trig.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <climits>
 #include <string>
 #include <cmath>
-#include <sstream>
-#include <iomanip>
+#include <random>
+#include <cstdlib>
+#include <thread>
 using namespace std;
 
+// Exact squared-distance thresholds for the overlap and blocking tests;
+// see DistanceKernel::Radius.
+static const DistanceKernel::Radius OVERLAP_RADIUS(SPRITE_WIDTH);
+static const DistanceKernel::Radius BLOCKING_RADIUS(SPRITE_WIDTH/2);
+
 GameWorld* createStudentWorld(string assetPath)
 {
 	return new StudentWorld(assetPath);
@@ -15,24 +26,118 @@ GameWorld* createStudentWorld(string assetPath)
 // Students:  Add code to this file, StudentWorld.h, Actor.h and Actor.cpp
 
 StudentWorld::StudentWorld(string assetPath)
-: GameWorld(assetPath)
+: GameWorld(assetPath), componentStore(this), blocking(BLOCKING_RADIUS), pursuit(SPRITE_WIDTH/2)
 {
     this->socrates = nullptr;
     vector<Actor*> a;
     this->actors = a;
+    this->nextActorID = 0;
+    this->tick = 0;
+    this->deferringEffects = false;
+    this->edibleInsertions = 0;
+    this->loaderStopping = false;
+    
+    // Every game plays out differently unless someone picks a seed.
+    random_device rd;
+    setSeed((static_cast<uint64_t>(rd()) << 32) | rd());
+    
+    if (const char* threads = getenv("KONTAGION_THREADS"))
+        setUpdateThreads(atoi(threads));
+    
+    if (getenv("KONTAGION_PROFILE") != nullptr)
+    {
+        profiler.setEnabled(true);
+        profiler.setDumpOnExit(true);
+    }
 }
 
 StudentWorld::~StudentWorld()
 {
-    //cleanUp();
+    // A level still being prepared has to finish before it can be cleared.
+    if (preparedLevel.valid())
+        preparedLevel.get();
+    if (loader.joinable())
+    {
+        {
+            lock_guard<mutex> lock(loaderMutex);
+            loaderStopping = true;
+        }
+        loaderWake.notify_one();
+        loader.join();
+    }
+    
+    // The actors' memory belongs to our pool, so make sure they're
+    // gone before it is.
+    if (socrates != nullptr)
+        cleanUpLevel();
+}
+
+void StudentWorld::prepareNextLevel()
+{
+    if (preparedLevel.valid())
+        return;
+    packaged_task<int()> task([this]
+    {
+        TRACE_ZONE("prepareNextLevel");
+        cleanUpLevel();
+        return initLevel();
+    });
+    preparedLevel = task.get_future();
+    {
+        lock_guard<mutex> lock(loaderMutex);
+        loaderTask = std::move(task);
+        if (!loader.joinable())
+            loader = thread(&StudentWorld::loaderLoop, this);
+    }
+    loaderWake.notify_one();
+}
+
+void StudentWorld::loaderLoop()
+{
+    unique_lock<mutex> lock(loaderMutex);
+    for (;;)
+    {
+        loaderWake.wait(lock, [this] { return loaderStopping || loaderTask.valid(); });
+        if (loaderStopping)
+            return;
+        packaged_task<int()> task = std::move(loaderTask);
+        lock.unlock();
+        Trace::setThreadName("level loader");
+        task();
+        lock.lock();
+    }
 }
 
 int StudentWorld::init()
 {
-    this->socrates = new Socrates(this);
-    addPits();
-    addFood();
-    addDirt();
+    if (preparedLevel.valid())
+        return preparedLevel.get();
+    return initLevel();
+}
+
+void StudentWorld::cleanUp()
+{
+    // A prepared level has already cleared the last one away.
+    if (preparedLevel.valid())
+    {
+        preparedLevel.wait();
+        return;
+    }
+    cleanUpLevel();
+}
+
+int StudentWorld::initLevel()
+{
+    // Lay the level out first; if it doesn't fit there is nothing to undo.
+    LevelLayout layout;
+    if (!layout.generate(getLevel(), rng))
+        return GWSTATUS_LEVEL_ERROR;
+    
+    this->socrates = new (this) Socrates(this);
+    componentStore.setType(socrates->getHandle(), ActorType::socrates);
+    addPits(layout);
+    addFood(layout);
+    addDirt(layout);
     
     
     return GWSTATUS_CONTINUE_GAME;
@@ -40,35 +145,60 @@ int StudentWorld::init()
 
 int StudentWorld::move()
 {
+    TRACE_ZONE("GameWorld::move");
     // This code is here merely to allow the game to build, run, and terminate after you hit enter.
     // Notice that the return value GWSTATUS_PLAYER_DIED will cause our framework to end the current level.
         
     bool levelDone = true;
     
+    tick++;
+    int firstNewID = nextActorID;
+    profiler.beginTick();
+    
     addGoodies();
+    profiler.endPhase(TickProfiler::GOODIES);
     
+    profiler.beginActor(ActorType::socrates);
     socrates->doSomething();
-    
-    for (int i = 0; i < actors.size(); i++ )
+    profiler.endActor();
+    profiler.endPhase(TickProfiler::SOCRATES);
+    
+    // Socrates is done moving and the dirt only changes in the sweep, so the
+    // chasers can all share one field for the rest of the tick. Any pit may
+    // still release one.
+    if (!categories[BACTERIA].empty() || !categories[PITS].empty())
+        pursuit.update(socrates->getX(), socrates->getY());
+    
+    // Actors spawned during the loop are appended and updated this tick too.
+    int updated;
+    if (workers != nullptr)
+        updated = 1 + updateActorsInPhases();
+    else if (!profiler.isEnabled())
     {
-         actors[i]->doSomething();
-         if (actors[i]->preventsLevelCompletion()) levelDone = false;
+        for (size_t i = 0; i < actors.size(); i++ )
+             actors[i]->doSomething();
+        updated = 1 + static_cast<int>(actors.size());
     }
-    
-    // Delete dead Actors
-    vector<Actor*>::iterator it = actors.begin();
-    for  (; it != actors.end(); )
+    else
     {
-        if (!(*it)->isAlive())
-        {
-            delete (*it);
-            it = actors.erase(it);
-        }
-        else
-            it++;
+        for (size_t i = 0; i < actors.size(); i++ )
+            updateActor(actors[i]);
+        updated = 1 + static_cast<int>(actors.size());
     }
+    profiler.endPhase(TickProfiler::ACTORS);
+    
+    // Every bacterium still in the dish (even one that died this tick) and
+    // every pit with bacteria left keeps the level going.
+    if (!categories[BACTERIA].empty()) levelDone = false;
+    for (size_t i = 0; i < categories[PITS].size(); i++)
+        if (categories[PITS][i]->preventsLevelCompletion()) levelDone = false;
+    
+    int died = removeDeadActors();
+    profiler.endPhase(TickProfiler::REMOVE_DEAD);
     
     sstream();
+    profiler.endPhase(TickProfiler::HUD);
+    profiler.endTick(updated, nextActorID - firstNewID, died);
     
     if (!socrates->isAlive())
     {
@@ -84,62 +214,499 @@ int StudentWorld::move()
     
 }
 
-void StudentWorld::cleanUp()
+void StudentWorld::cleanUpLevel()
 {
     // Delete Socrates. good night sweet prince 😔✊✊
-    delete socrates;
+    if (socrates != nullptr)
+        socrates->~Socrates();
     
     // Delete all the other actors 🙄
-    vector<Actor*>::iterator it = actors.begin();
-    for ( ; it != actors.end(); )
+    // Everything goes at once, so run the destructors, drop the containers
+    // in one go and give the whole level's memory back to the pool in a
+    // single reset instead of freeing actors one at a time.
+    for (int c = 0; c < NUM_CATEGORIES; c++)
     {
-        delete *it;
-        it = actors.erase(it);
+        for (size_t i = 0; i < categories[c].size(); i++)
+            categories[c][i]->~Actor();
     }
+    forgetLevel();
+    pool.reset();
+    componentStore.reset();
 }
 
-void StudentWorld::addActor(Actor* actor)
+void StudentWorld::discardLevel()
 {
-    actors.push_back(actor);
+    delete socrates;
+    for (int c = 0; c < NUM_CATEGORIES; c++)
+    {
+        for (size_t i = 0; i < categories[c].size(); i++)
+            delete categories[c][i];
+    }
+    forgetLevel();
+    componentStore.clearPendingDeaths();
 }
 
-bool StudentWorld::isBacteriumMovementBlockedAt(double x, double y) const
+void StudentWorld::forgetLevel()
 {
-    double distFromCenter = sqrt(pow(VIEW_WIDTH/2 - x, 2) + pow(VIEW_HEIGHT/2 - y, 2));
-    if (distFromCenter >= VIEW_RADIUS) return true;
+    socrates = nullptr;
+    actors.clear();
+    for (int c = 0; c < NUM_CATEGORIES; c++)
+    {
+        categories[c].clear();
+        grids[c].clear();
+    }
+    blocking.clearObstacles();
+    pursuit.clearObstacles();
+}
+
+void StudentWorld::updateActor(Actor* actor)
+{
+    if (!profiler.isEnabled())
+    {
+        actor->doSomething();
+        return;
+    }
+    profiler.beginActor(componentStore.type(actor->getHandle()));
+    actor->doSomething();
+    profiler.endActor();
+}
+
+int StudentWorld::updateActorsInPhases()
+{
+    // Everything but the bacteria goes first, in order. Bacteria a pit
+    // releases here are appended and join this tick's batch.
+    bacteriaBatch.clear();
+    for (size_t i = 0; i < actors.size(); i++)
+    {
+        if (categoryOf(componentStore.type(actors[i]->getHandle())) == BACTERIA)
+            bacteriaBatch.push_back(actors[i]);
+        else
+            updateActor(actors[i]);
+    }
     
-    //std::vector<Actor*>::const_iterator it = actors.begin();
-    //for ( ; it != actors.end(); it++)
-    for (int i = 0; i < actors.size(); i++)
+    deferringEffects = true;
+    if (profiler.isEnabled())
     {
-        if (actors[i]->blocks())
+        // The profiler's counters aren't thread-safe; keep to this thread.
+        for (size_t i = 0; i < bacteriaBatch.size(); i++)
+            updateActor(bacteriaBatch[i]);
+    }
+    else
+    {
+        const int BACTERIA_PER_CHUNK = 64;
+        workers->parallelFor(static_cast<int>(bacteriaBatch.size()), BACTERIA_PER_CHUNK, [this](int begin, int end)
+        {
+            TRACE_ZONE("bacteria intents");
+            for (int i = begin; i < end; i++)
+                bacteriaBatch[i]->doSomething();
+        });
+    }
+    deferringEffects = false;
+    int updated = static_cast<int>(actors.size());
+    
+    TRACE_ZONE("bacteria commit");
+    for (size_t i = 0; i < bacteriaBatch.size(); i++)
+        static_cast<Bacterium*>(bacteriaBatch[i])->commitIntent();
+    return updated;
+}
+
+int StudentWorld::removeDeadActors()
+{
+    // Nothing died since the last sweep, so there is nothing to sweep.
+    if (componentStore.pendingDeaths() == 0)
+        return 0;
+    componentStore.clearPendingDeaths();
+    
+    // Single pass per container: slide every living actor down over the dead
+    // ones, then chop off the tail. Living actors keep their relative order,
+    // so the next tick updates them in the same order as before.
+    size_t kept = 0;
+    for (size_t i = 0; i < actors.size(); i++)
+    {
+        if (actors[i]->isAlive())
+            actors[kept++] = actors[i];
+    }
+    actors.resize(kept);
+    
+    int removed = 0;
+    for (int c = 0; c < NUM_CATEGORIES; c++)
+    {
+        vector<Actor*>& category = categories[c];
+        kept = 0;
+        for (size_t i = 0; i < category.size(); i++)
         {
-            double blockX = actors[i]->getX();
-            double blockY = actors[i]->getY();
-            double distance = sqrt(pow(blockX - x, 2) + pow(blockY - y, 2));
-            if (distance <= SPRITE_WIDTH/2)
-                return true;
+            if (category[i]->isAlive())
+                category[kept++] = category[i];
+            else
+            {
+                grids[c].remove(category[i]);
+                if (c == BLOCKERS)
+                {
+                    blocking.removeObstacle(category[i]->getX(), category[i]->getY());
+                    pursuit.removeObstacle(category[i]->getX(), category[i]->getY());
+                }
+                delete category[i];
+                removed++;
+            }
         }
-            
+        category.resize(kept);
+    }
+    return removed;
+}
+
+void StudentWorld::addActor(Actor* actor)
+{
+    ActorType type = actor->getType();
+    ActorCategory category = categoryOf(type);
+    componentStore.setType(actor->getHandle(), type);
+    actor->setID(nextActorID++);
+    categories[category].push_back(actor);
+    if (!isStatic(category))
+        actors.push_back(actor);
+    if (isIndexed(category))
+        grids[category].insert(actor);
+    if (category == BLOCKERS)
+    {
+        blocking.addObstacle(actor->getX(), actor->getY());
+        pursuit.addObstacle(actor->getX(), actor->getY());
+    }
+    if (category == EDIBLES)
+    {
+        int entry = static_cast<int>(edibleInsertions++ % EDIBLE_LOG_SIZE);
+        edibleLogX[entry] = actor->getX();
+        edibleLogY[entry] = actor->getY();
+    }
+}
+
+void StudentWorld::setSeed(uint64_t seed)
+{
+    this->seed = seed;
+    rng.setSeed(seed);
+}
+
+uint64_t StudentWorld::getSeed() const
+{
+    return seed;
+}
+
+long StudentWorld::getTick() const
+{
+    return tick;
+}
+
+// A snapshot is the magic and a format version, then the world's record,
+// then Socrates and every other Actor in ID order, then a checksum of all
+// the bytes before it. Each Actor is its type, ID, position and direction
+// followed by whatever its writeState() adds. Bump the version whenever
+// any of that changes.
+static const char SNAPSHOT_MAGIC[4] = { 'K', 'T', 'G', 'N' };
+static const int SNAPSHOT_VERSION = 1;
+static const size_t SNAPSHOT_CHECKSUM_SIZE = 8;
+
+// isSnapshotPosition(double x, double y)
+// Returns true if (x,y) is somewhere an Actor can really be. Nothing gets
+// farther from the centre than a spray fired outwards from the rim, which
+// ends up about VIEW_WIDTH away.
+static bool isSnapshotPosition(double x, double y)
+{
+    return isfinite(x) && isfinite(y)
+        && abs(x - VIEW_RADIUS) <= VIEW_WIDTH && abs(y - VIEW_RADIUS) <= VIEW_WIDTH;
+}
+
+bool StudentWorld::saveSnapshot(vector<uint8_t>& out) const
+{
+    out.clear();
+    if (socrates == nullptr)
+        return false;
+    
+    out.insert(out.end(), SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC));
+    SnapshotWriter writer(out);
+    writer.writeInt(SNAPSHOT_VERSION);
+    
+    writer.writeInt(getLevel());
+    writer.writeInt(getLives());
+    writer.writeInt(getScore());
+    writer.writeUInt64(seed);
+    uint64_t state[4];
+    rng.getState(state);
+    for (int i = 0; i < 4; i++)
+        writer.writeUInt64(state[i]);
+    writer.writeLong(tick);
+    writer.writeInt(nextActorID);
+    
+    writer.writeInt(socrates->isAlive() ? 1 : 0);
+    writer.writeDouble(socrates->getX());
+    writer.writeDouble(socrates->getY());
+    writer.writeInt(socrates->getDirection());
+    socrates->writeState(writer);
+    
+    // Restoring adds them back in this order, which keeps the update order
+    // and every tie that goes to the lower ID the same.
+    vector<Actor*> all;
+    for (int c = 0; c < NUM_CATEGORIES; c++)
+        all.insert(all.end(), categories[c].begin(), categories[c].end());
+    sort(all.begin(), all.end(), [](Actor* a, Actor* b) { return a->getID() < b->getID(); });
+    
+    writer.writeInt(static_cast<int>(all.size()));
+    for (Actor* a : all)
+    {
+        writer.writeInt(static_cast<int>(a->getType()));
+        writer.writeInt(a->getID());
+        writer.writeDouble(a->getX());
+        writer.writeDouble(a->getY());
+        writer.writeInt(a->getDirection());
+        a->writeState(writer);
     }
     
-    return false;
+    writer.writeUInt64(snapshotChecksum(out.data(), out.size()));
+    return true;
 }
 
-Actor* StudentWorld::getOverlappingEdible(Actor *overlappingActor) const
+bool StudentWorld::restoreSnapshot(const vector<uint8_t>& in)
 {
-    std::vector<Actor*>::const_iterator it = actors.begin();
-    for ( ; it != actors.end(); it++)
+    // Check everything that can be checked before anything is thrown away.
+    if (in.size() < sizeof(SNAPSHOT_MAGIC) + SNAPSHOT_CHECKSUM_SIZE
+        || !equal(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC), in.begin()))
+        return false;
+    size_t bodySize = in.size() - SNAPSHOT_CHECKSUM_SIZE;
+    SnapshotReader trailer(in.data() + bodySize, SNAPSHOT_CHECKSUM_SIZE);
+    if (trailer.readUInt64() != snapshotChecksum(in.data(), bodySize))
+        return false;
+    SnapshotReader reader(in.data() + sizeof(SNAPSHOT_MAGIC), bodySize - sizeof(SNAPSHOT_MAGIC));
+    if (reader.readInt() != SNAPSHOT_VERSION || !reader.ok())
+        return false;
+    
+    int level = reader.readInt(0, INT_MAX);
+    int lives = reader.readInt(0, INT_MAX);
+    int score = reader.readInt();
+    uint64_t savedSeed = reader.readUInt64();
+    uint64_t state[4];
+    for (int i = 0; i < 4; i++)
+        state[i] = reader.readUInt64();
+    long long savedTick = reader.readLong();
+    int savedNextID = reader.readInt(0, INT_MAX);
+    if (!reader.ok())
+        return false;
+    
+    // The loader thread shares the pool and the component arrays with what
+    // is built below. A level it prepared is replaced like any other.
+    if (preparedLevel.valid())
+        preparedLevel.wait();
+    
+    // Build the saved level next to the one in progress, which is only
+    // thrown away once all of this has been read. Until then nothing built
+    // here is part of the world.
+    vector<Actor*> staged;
+    vector<int> stagedIDs;
+    auto abandon = [&staged]()
+    {
+        for (Actor* actor : staged)
+            delete actor;
+        return false;
+    };
+    
+    bool socratesAlive = reader.readInt(0, 1) != 0;
+    double socratesX = reader.readDouble();
+    double socratesY = reader.readDouble();
+    int socratesDirection = reader.readInt(0, 359);
+    if (!reader.ok() || !isSnapshotPosition(socratesX, socratesY))
+        return false;
+    Socrates* savedSocrates = new (this) Socrates(this);
+    staged.push_back(savedSocrates);
+    savedSocrates->moveTo(socratesX, socratesY);
+    savedSocrates->setDirection(socratesDirection);
+    savedSocrates->readState(reader);
+    
+    // IDs have to come strictly in order, as they were saved, for every tie
+    // the queries break by lowest ID to come out the same.
+    int count = reader.readInt(0, INT_MAX);
+    int lastID = -1;
+    for (int i = 0; i < count; i++)
     {
-        if (overlap(*it, overlappingActor) && (*it)->isEdible() && (*it)->isAlive())
-            return *it;
+        ActorType type = static_cast<ActorType>(reader.readInt(0, NUM_ACTOR_TYPES - 1));
+        int id = reader.readInt(lastID + 1, savedNextID - 1);
+        double x = reader.readDouble();
+        double y = reader.readDouble();
+        int direction = reader.readInt(0, 359);
+        if (!reader.ok() || type == ActorType::socrates || !isSnapshotPosition(x, y))
+            return abandon();
+        Actor* actor = createActor(type, x, y);
+        staged.push_back(actor);
+        stagedIDs.push_back(id);
+        actor->setDirection(direction);
+        actor->readState(reader);
+        lastID = id;
     }
+    if (!reader.ok() || !reader.atEnd())
+        return abandon();
+    
+    // All of it parsed, so now the level in progress makes way.
+    discardLevel();
+    setProgress(level, lives, score);
+    setSeed(savedSeed);
+    rng.setState(state);
+    
+    this->socrates = savedSocrates;
+    componentStore.setType(socrates->getHandle(), ActorType::socrates);
+    if (!socratesAlive)
+        componentStore.setAlive(socrates->getHandle(), false);
+    for (size_t i = 1; i < staged.size(); i++)
+    {
+        nextActorID = stagedIDs[i - 1];
+        addActor(staged[i]);
+    }
+    nextActorID = savedNextID;
+    this->tick = static_cast<long>(savedTick);
+    return true;
+}
+
+int StudentWorld::randInt(int min, int max)
+{
+    return rng.randInt(min, max);
+}
+
+int StudentWorld::getNumBacteria() const
+{
+    return static_cast<int>(categories[BACTERIA].size());
+}
+
+ActorPool& StudentWorld::actorPool()
+{
+    return pool;
+}
+
+ActorComponents& StudentWorld::components()
+{
+    return componentStore;
+}
+
+const ActorComponents& StudentWorld::components() const
+{
+    return componentStore;
+}
+
+TickProfiler& StudentWorld::tickProfiler()
+{
+    return profiler;
+}
+
+const TickProfiler& StudentWorld::tickProfiler() const
+{
+    return profiler;
+}
+
+void StudentWorld::setUpdateThreads(int threads)
+{
+    if (threads == 1)
+    {
+        workers.reset();
+        return;
+    }
+    if (threads <= 0)
+        threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    // Hand the old pool's workers back before the new one asks for its own.
+    workers.reset();
+    workers.reset(new WorkerPool(threads));
+}
+
+int StudentWorld::getUpdateThreads() const
+{
+    return workers != nullptr ? workers->size() : 1;
+}
+
+bool StudentWorld::isDeferringEffects() const
+{
+    return deferringEffects;
+}
+
+void StudentWorld::actorMoved(Actor* actor)
+{
+    // Only actors that were put in a grid have a cell to update. Bacteria
+    // moving in the parallel phase are re-bucketed when they commit.
+    if (deferringEffects)
+        return;
+    if (actor->getGridCell() >= 0)
+        grids[categoryOf(componentStore.type(actor->getHandle()))].update(actor);
+}
+
+StudentWorld::ActorCategory StudentWorld::categoryOf(ActorType type)
+{
+    switch (type)
+    {
+        case ActorType::dirt:
+            return BLOCKERS;
+        case ActorType::food:
+            return EDIBLES;
+        case ActorType::regularSalmonella:
+        case ActorType::aggressiveSalmonella:
+        case ActorType::eColi:
+            return BACTERIA;
+        case ActorType::flame:
+        case ActorType::disinfectantSpray:
+            return PROJECTILES;
+        case ActorType::restoreHealthGoodie:
+        case ActorType::flamethrowerGoodie:
+        case ActorType::extraLifeGoodie:
+        case ActorType::fungus:
+            return GOODIES;
+        case ActorType::pit:
+        default:
+            // Socrates is kept apart from the other actors and never gets filed.
+            return PITS;
+    }
+}
+
+bool StudentWorld::isStatic(ActorCategory category)
+{
+    return category == BLOCKERS || category == EDIBLES;
+}
+
+bool StudentWorld::isIndexed(ActorCategory category)
+{
+    // Blockers, edibles and the damageable bacteria and goodies are looked up
+    // by position. Nobody asks what's near a projectile or a pit.
+    return category == BLOCKERS || category == EDIBLES || category == BACTERIA || category == GOODIES;
+}
+
+bool StudentWorld::isBacteriumMovementBlockedAt(double x, double y) const
+{
+    profiler.countQuery();
+    // The raster settles all but the points right at the edge of a dirt
+    // pile or of the dish.
+    BlockingRaster::Answer answer = blocking.test(x, y);
+    if (answer != BlockingRaster::UNSURE)
+        return answer == BlockingRaster::BLOCKED;
     
-    return nullptr;
+    double distFromCenter = sqrt(pow(VIEW_WIDTH/2 - x, 2) + pow(VIEW_HEIGHT/2 - y, 2));
+    if (distFromCenter >= VIEW_RADIUS) return true;
+    
+    return grids[BLOCKERS].anyWithin(x, y, BLOCKING_RADIUS);
+}
+
+Actor* StudentWorld::getOverlappingEdible(Actor *overlappingActor) const
+{
+    profiler.countQuery();
+    // The grid doesn't visit actors in the order they were added, so keep
+    // the match with the lowest ID to return the same one a scan of actors would.
+    Actor* edible = nullptr;
+    grids[EDIBLES].forEachWithin(overlappingActor->getX(), overlappingActor->getY(), OVERLAP_RADIUS, [&](Actor* actor)
+    {
+        if (edible != nullptr && edible->getID() < actor->getID()) return;
+        if (actor->isAlive())
+            edible = actor;
+    });
+    
+    return edible;
+}
+
+Socrates* StudentWorld::getSocrates() const
+{
+    return socrates;
 }
 
 Socrates* StudentWorld::getOverlappingSocrates(Actor *overlappingActor) const
 {
+    profiler.countQuery();
     if (overlap(socrates, overlappingActor))
         return socrates;
     return nullptr;
@@ -147,14 +714,24 @@ Socrates* StudentWorld::getOverlappingSocrates(Actor *overlappingActor) const
 
 bool StudentWorld::damageOneActor(Actor *actor, int damage)
 {
-    std::vector<Actor*>::const_iterator it = actors.begin();
-    for ( ; it != actors.end(); it++)
+    profiler.countQuery();
+    // Dirt, bacteria and goodies are the damageable populations.
+    // Keep the lowest ID across all three so the same actor gets hit as before.
+    Actor* victim = nullptr;
+    auto consider = [&](Actor* other)
     {
-        if (overlap(*it, actor) && (*it)->isDamageable() && (*it)->isAlive())
-        {
-            (*it)->takeDamage(damage);
-            return true;
-        }
+        if (victim != nullptr && victim->getID() < other->getID()) return;
+        if (other->isAlive())
+            victim = other;
+    };
+    grids[BLOCKERS].forEachWithin(actor->getX(), actor->getY(), OVERLAP_RADIUS, consider);
+    grids[BACTERIA].forEachWithin(actor->getX(), actor->getY(), OVERLAP_RADIUS, consider);
+    grids[GOODIES].forEachWithin(actor->getX(), actor->getY(), OVERLAP_RADIUS, consider);
+    
+    if (victim != nullptr)
+    {
+        victim->takeDamage(damage);
+        return true;
     }
     
     return false;
@@ -162,41 +739,43 @@ bool StudentWorld::damageOneActor(Actor *actor, int damage)
 
 bool StudentWorld::getAngleToNearbySocrates(Actor* a, int dist, int& angle) const
 {
+    profiler.countQuery();
     double distance = sqrt(pow(socrates->getX() - a->getX(), 2) + pow(socrates->getY() - a->getY(), 2));
     if (distance <= dist)
     {
-        const double PI = 4 * atan(1);
-        angle = atan2(socrates->getY() / VIEW_RADIUS - a->getY()/ VIEW_RADIUS, socrates->getX()/VIEW_RADIUS - a->getX()/VIEW_RADIUS) * 180 / PI;
+        angle = Trig::atan2Degrees(socrates->getY() / VIEW_RADIUS - a->getY()/ VIEW_RADIUS, socrates->getX()/VIEW_RADIUS - a->getX()/VIEW_RADIUS);
         return true;
     }
     return false;
 }
 
-bool StudentWorld::getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle) const
+bool StudentWorld::getPursuitAngleToSocrates(Actor* a, int dist, int& angle, bool& routed) const
 {
-    double minDist = dist;
-    double minX = 0, minY = 0;
-    bool found = false;
+    routed = false;
+    if (!getAngleToNearbySocrates(a, dist, angle))
+        return false;
     
-    for (int i = 0; i < actors.size(); i++)
+    // move() brought the field up to date for this tick.
+    int fieldAngle;
+    if (pursuit.angleFrom(a->getX(), a->getY(), fieldAngle))
     {
-        if (actors[i]->isEdible())
-        {
-            double distance = sqrt(pow(a->getX() - actors[i]->getX(), 2) + pow(a->getY() - actors[i]->getY(), 2));
-            if (distance < minDist)
-            {
-                minDist = distance;
-                minX = actors[i]->getX()/VIEW_RADIUS - a->getX()/VIEW_RADIUS;
-                minY = actors[i]->getY()/VIEW_RADIUS - a->getY()/VIEW_RADIUS;
-                found = true;
-            }
-        }
+        angle = fieldAngle;
+        routed = true;
     }
+    return true;
+}
+
+bool StudentWorld::getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle) const
+{
+    profiler.countQuery();
+    // Ties go to the lowest ID, matching a front-to-back scan of actors.
+    Actor* nearest = grids[EDIBLES].nearestWithin(a->getX(), a->getY(), dist);
     
-    if (found)
+    if (nearest != nullptr)
     {
-        const double PI = 4 * atan(1);
-        angle = atan2(minY, minX) * 180 / PI;
+        double minX = nearest->getX()/VIEW_RADIUS - a->getX()/VIEW_RADIUS;
+        double minY = nearest->getY()/VIEW_RADIUS - a->getY()/VIEW_RADIUS;
+        angle = Trig::atan2Degrees(minY, minX);
         return true;
     }
 
@@ -204,32 +783,75 @@ bool StudentWorld::getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle)
     
 }
 
-void StudentWorld::sstream()
+bool StudentWorld::getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle, EdibleTarget& target) const
 {
+    if (!isTargetCurrent(a, dist, target))
+    {
+        profiler.countQuery();
+        Actor* nearest = grids[EDIBLES].nearestWithin(a->getX(), a->getY(), dist);
+        target.x = a->getX();
+        target.y = a->getY();
+        target.dist = dist;
+        target.insertions = edibleInsertions;
+        target.food = ActorComponents::Ref();
+        target.distance = dist;
+        if (nearest != nullptr)
+        {
+            // Worked out the way the search does, so later comparisons are exact.
+            double dx = nearest->getX() - target.x, dy = nearest->getY() - target.y;
+            target.food = componentStore.ref(nearest->getHandle());
+            target.distance = sqrt(dx * dx + dy * dy);
+        }
+    }
     
-    ostringstream stream, stream2, stream3, stream4, stream5, stream6;
-    stream << right;
-    string toScreen;
-    
-    toScreen = toScreen + "Score: ";
-    stream << setw(6);
-    stream << setfill('0');
-    stream << getScore();
-    toScreen = toScreen + stream.str();
-    toScreen = toScreen + "  Level: ";
-    stream2 << setw(2) << setfill(' ') << getLevel();
-    toScreen = toScreen + stream2.str() + "  Lives: ";
-    stream3 << setw(2) << setfill(' ') << getLives();
-    toScreen = toScreen + stream3.str() + "  Health: ";
-    stream4 << setw(3) << setfill(' ') << socrates->getHP();
-    toScreen = toScreen + stream4.str() + "  Sprays: ";
-    stream5 << setw(2) << setfill(' ') << socrates->getSprayCharges();
-    toScreen = toScreen + stream5.str() + "  Flames: ";
-    stream6 << setw(2) << setfill(' ') << socrates->getFlameCharges();
-    toScreen = toScreen + stream6.str();
-    
-    setGameStatText(toScreen);
+    Actor* nearest = componentStore.actor(target.food);
+    if (nearest != nullptr)
+    {
+        double minX = nearest->getX()/VIEW_RADIUS - a->getX()/VIEW_RADIUS;
+        double minY = nearest->getY()/VIEW_RADIUS - a->getY()/VIEW_RADIUS;
+        angle = Trig::atan2Degrees(minY, minX);
+        return true;
+    }
     
+    return false;
+}
+
+bool StudentWorld::isTargetCurrent(Actor* a, int dist, const EdibleTarget& target) const
+{
+    if (target.dist != dist || target.x != a->getX() || target.y != a->getY())
+        return false;
+    
+    // Removing other edibles can't make the target any less the nearest,
+    // but removing the target itself can.
+    if (target.food.handle >= 0 && componentStore.actor(target.food) == nullptr)
+        return false;
+    
+    // Edibles added since then win only if strictly closer. Too many to
+    // check individually means searching again.
+    if (edibleInsertions - target.insertions > EDIBLE_LOG_SIZE)
+        return false;
+    for (long i = target.insertions; i < edibleInsertions; i++)
+    {
+        int entry = static_cast<int>(i % EDIBLE_LOG_SIZE);
+        double dx = edibleLogX[entry] - target.x, dy = edibleLogY[entry] - target.y;
+        if (sqrt(dx * dx + dy * dy) < target.distance)
+            return false;
+    }
+    return true;
+}
+
+void StudentWorld::sstream()
+{
+    hud.set(HudText::SCORE, getScore());
+    hud.set(HudText::LEVEL, getLevel());
+    hud.set(HudText::LIVES, getLives());
+    hud.set(HudText::HEALTH, socrates->getHP());
+    hud.set(HudText::SPRAYS, socrates->getSprayCharges());
+    hud.set(HudText::FLAMES, socrates->getFlameCharges());
+    hud.update();
+    
+    // Only a pointer changes hands; the text itself lives in hud.
+    setGameStatText(hud.text());
 }
 
 void StudentWorld::addGoodies()
@@ -245,7 +867,7 @@ void StudentWorld::addGoodies()
         double x = randomX/VIEW_RADIUS;
         double y = randomY/VIEW_RADIUS ;
         double angle = 0;
-        const double PI = 4 * atan(1);
+        const double PI = Trig::PI;
         
         // atan returns values (-180, 180), so we gotta catch the case when its Socrates is in 2nd, 3rd quadrants
         if (x < 0)
@@ -255,7 +877,7 @@ void StudentWorld::addGoodies()
         
         x = VIEW_RADIUS*cos(angle) + VIEW_RADIUS;
         y = VIEW_RADIUS*sin(angle) + VIEW_RADIUS;
-        addActor(new Fungus(goodieLifeTime, this, x, y));
+        addActor(new (this) Fungus(goodieLifeTime, this, x, y));
     }
     
     //Spawn goodies
@@ -266,7 +888,7 @@ void StudentWorld::addGoodies()
         double x = randomX/VIEW_RADIUS;
         double y = randomY/VIEW_RADIUS ;
         double angle = 0;
-        const double PI = 4 * atan(1);
+        const double PI = Trig::PI;
         
         // atan returns values (-180, 180), so we gotta catch the case when its Socrates is in 2nd, 3rd quadrants
         if (x < 0)
@@ -278,9 +900,9 @@ void StudentWorld::addGoodies()
         y = VIEW_RADIUS*sin(angle) + VIEW_RADIUS;
         
         random = randInt(1, 10);
-        if (random >= 1 && random <= 6) addActor(new RestoreHealthGoodie(goodieLifeTime, this, x, y));
-        if (random == 10 )              addActor(new ExtraLifeGoodie(goodieLifeTime, this, x, y));
-        else                            addActor(new FlamethrowerGoodie(goodieLifeTime, this, x, y));
+        if (random >= 1 && random <= 6) addActor(new (this) RestoreHealthGoodie(goodieLifeTime, this, x, y));
+        if (random == 10 )              addActor(new (this) ExtraLifeGoodie(goodieLifeTime, this, x, y));
+        else                            addActor(new (this) FlamethrowerGoodie(goodieLifeTime, this, x, y));
         
         
     }
@@ -288,109 +910,51 @@ void StudentWorld::addGoodies()
     
 }
 
-void StudentWorld::addPits()
+void StudentWorld::addPits(const LevelLayout& layout)
 {
-    bool overlappingPits = false;
-    if (actors.size() != 0) return;
-    int L = getLevel();
-    double x = 0, y = 0;
-    
-    // If actors is empty, add any random Pit
-    // Else, generate a Pit and check for overlaps.
-    // If it overlaps, delete the Pit and redo the
-    // current iteration of the loop by decrementing the counter
-    for (int i = 0; i < L; i++)
-    {
-        getPositionInViewRadius(x, y);
-        Pit* pitricia = new Pit(this, x, y);
-        if (actors.size() == 0)
-            actors.push_back(pitricia);
-        else
-        {
-            vector<Actor*>::iterator it = actors.begin();
-            for ( ; it != actors.end(); it++)
-            {
-                if (overlap((*it), pitricia))
-                    overlappingPits = true;
-            }
-        }
-        
-        if (overlappingPits)
-        {
-            delete pitricia;
-            i--;
-        }
-        else if (actors.size() != 1)
-            actors.push_back(pitricia);
-    }
-    
+    for (const LevelLayout::Position& p : layout.pits())
+        addActor(new (this) Pit(this, p.x, p.y));
 }
 
-void StudentWorld::addFood()
+void StudentWorld::addFood(const LevelLayout& layout)
 {
-    int L = getLevel();
-    
-    // Spawn Food.
-    int numFood = min(5*L,25);
-    for (int i = 0; i < numFood; i++)
-    {
-        bool overlapsPitOrFood = false;
-        double x = 0, y = 0;
-        getPositionInViewRadius(x, y);
-        
-        Food* fredTheFoodie = new Food(this, x, y);
-        
-        vector<Actor*>::iterator it = actors.begin();
-        for ( ;it != actors.end(); it++)
-        {
-            if (overlap((*it), fredTheFoodie))
-                overlapsPitOrFood = true;
-        }
-        
-        if (overlapsPitOrFood)
-        {
-            delete fredTheFoodie; // sad.
-            numFood++;
-        }
-        else
-            actors.push_back(fredTheFoodie);
-        
-    }
+    for (const LevelLayout::Position& p : layout.food())
+        addActor(new (this) Food(this, p.x, p.y));
 }
 
-void StudentWorld::addDirt()
+void StudentWorld::addDirt(const LevelLayout& layout)
 {
-    
-    int L = getLevel();
-    // Spawn Dirt piles.
-    int numPiles = max(180-20*L, 20);
-    
-    for (int i = 0; i < numPiles; i++)
+    //Add dirt to our Actor* container 💩 ➕ 📦[🎭]
+    for (const LevelLayout::Position& p : layout.dirt())
+        addActor(new (this) Dirt(this, p.x, p.y));
+}
+
+Actor* StudentWorld::createActor(ActorType type, double x, double y)
+{
+    // The goodies' lifetimes and the projectiles' ranges are placeholders
+    // until readState() puts the saved ones in.
+    Actor* actor = nullptr;
+    switch (type)
     {
-        bool overlapsPitsOrFood = false;
-        double x = 0, y = 0;
-        getPositionInViewRadius(x, y);
-        
-        Dirt* dirtyDan = new Dirt(this, x, y);
-        
-        // Check if our dirt pile overlaps with any food or pits.
-        vector<Actor*>::iterator it = actors.begin();
-        for( ; it != actors.end(); it++)
-        {
-            if (overlap((*it), dirtyDan) && !(*it)->blocks())
-                overlapsPitsOrFood = true;
-        }
-        // PROBLEM we dont check for overlap
-        
-        if (overlapsPitsOrFood)
-        {
-            delete dirtyDan;  // sad.
-            numPiles++;
-        }
-        //Add dirt to our Actor* container 💩 ➕ 📦[🎭]
-        else
-            actors.push_back(dirtyDan);
+        case ActorType::dirt:                   actor = new (this) Dirt(this, x, y); break;
+        case ActorType::pit:                    actor = new (this) Pit(this, x, y); break;
+        case ActorType::regularSalmonella:      actor = new (this) RegularSalmonella(this, x, y); break;
+        case ActorType::aggressiveSalmonella:   actor = new (this) AggressiveSalmonella(this, x, y); break;
+        case ActorType::eColi:                  actor = new (this) EColi(this, x, y); break;
+        case ActorType::restoreHealthGoodie:    actor = new (this) RestoreHealthGoodie(0, this, x, y); break;
+        case ActorType::flamethrowerGoodie:     actor = new (this) FlamethrowerGoodie(0, this, x, y); break;
+        case ActorType::extraLifeGoodie:        actor = new (this) ExtraLifeGoodie(0, this, x, y); break;
+        case ActorType::fungus:                 actor = new (this) Fungus(0, this, x, y); break;
+        case ActorType::food:                   actor = new (this) Food(this, 0, 0); break;
+        case ActorType::flame:                  actor = new (this) Flame(this, 0, 0, 0); break;
+        case ActorType::disinfectantSpray:      actor = new (this) DisinfectantSpray(this, 0, 0, 0); break;
+        case ActorType::socrates:               return nullptr;
     }
+    
+    // Food and the projectiles only take whole pixels.
+    if (actor->getX() != x || actor->getY() != y)
+        actor->moveTo(x, y);
+    return actor;
 }
 
 bool StudentWorld::overlap(Actor *actor1, Actor *actor2) const
@@ -404,24 +968,8 @@ bool StudentWorld::overlap(Actor *actor1, Actor *actor2) const
     double y1 = actor1->getY();
     double x2 = actor2->getX();
     double y2 = actor2->getY();
-    double distance = sqrt(pow(x2 - x1, 2) + pow(y2 - y1, 2));
-    overlap = (distance <= SPRITE_WIDTH) ? true : false;
+    overlap = DistanceKernel::within(x2 - x1, y2 - y1, OVERLAP_RADIUS);
     
     return overlap;
 }
 
-void StudentWorld::getPositionInViewRadius(double &x, double &y) const
-{
-    bool valid = false;
-    // Generate (x,y) coordinates until they are valid.
-    // By valid, we mean that it is within 120 pixels
-    // of our circle. The distance formula is used to check.
-    while (!valid)
-    {
-        x = randInt(0 + SPRITE_WIDTH, VIEW_WIDTH - 1);
-        y = randInt(0 + SPRITE_HEIGHT, VIEW_HEIGHT - 1);
-        double distance = sqrt(pow(x - VIEW_RADIUS, 2) + pow(y - VIEW_RADIUS, 2));
-        valid = (distance <= 120) ? true : false;
-    }
-}
-
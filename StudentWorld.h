@@ -3,7 +3,24 @@
 
 //#include "Actor.h" cant do this or help we get stuck in circular includes
 #include "GameWorld.h"
+#include "SpatialGrid.h"
+#include "ActorPool.h"
+#include "ActorComponents.h"
+#include "ActorType.h"
+#include "RandomGenerator.h"
+#include "TickProfiler.h"
+#include "HudText.h"
+#include "WorkerPool.h"
+#include "PursuitField.h"
+#include "BlockingRaster.h"
+#include "LevelLayout.h"
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Students:  Add code to this file, StudentWorld.cpp, Actor.h, and Actor.cpp
@@ -19,12 +36,107 @@ public:
     virtual int init();
     virtual int move();
     virtual void cleanUp();
+    
+    // prepareNextLevel()
+    // Runs cleanUp() and init() on the world's loader thread right away, so
+    // that the controller's own calls only have to collect the result;
+    // cleanUp() on a world with no level in it does nothing. The level comes
+    // out exactly as it would have on the calling thread. Every level is
+    // prepared on the same thread, which lives as long as the world.
+    virtual void prepareNextLevel();
 
     // addActor(Actor* actor)
     // Adds an actor to our StudentWorld
     // Primarily used by bacterium to multiply after consuming enough Food.
     void addActor(Actor* actor);
     
+    // setSeed(std::uint64_t seed)
+    // Reseeds this world's random number generator. Two worlds with the
+    // same seed that get the same key presses play out identically.
+    void setSeed(std::uint64_t seed);
+    
+    // getSeed()
+    // Returns the seed last given to setSeed().
+    std::uint64_t getSeed() const;
+    
+    // getTick()
+    // Returns how many times move() has been called in this world.
+    long getTick() const;
+    
+    // saveSnapshot(std::vector<std::uint8_t>& out)
+    // Replaces out with a compact binary snapshot of the level in progress:
+    // level, lives and score, the random state, the tick, and every Actor.
+    // Call it between ticks. Returns false, leaving out empty, if there is
+    // no level in progress.
+    bool saveSnapshot(std::vector<std::uint8_t>& out) const;
+    
+    // restoreSnapshot(const std::vector<std::uint8_t>& in)
+    // Replaces the level in progress with the one saved in in, which then
+    // plays on exactly as the saved one would have. Returns false without
+    // touching the level in progress if in isn't a snapshot this version
+    // reads: wrong format or version, truncated or damaged, or holding what
+    // no level could (a position off the dish, actor IDs out of order).
+    bool restoreSnapshot(const std::vector<std::uint8_t>& in);
+    
+    // randInt(int min, int max)
+    // Returns a uniformly distributed random int from min to max, inclusive,
+    // drawn from this world's own generator. Used for level layout and goodies;
+    // actors roll from their own streams instead (see Actor::randInt).
+    int randInt(int min, int max);
+    
+    // getNumBacteria()
+    // Returns how many bacteria are in the dish.
+    int getNumBacteria() const;
+    
+    // actorPool()
+    // Returns the pool every Actor in this world is allocated from.
+    // Its stats() show how much heap traffic the actors cause.
+    ActorPool& actorPool();
+    
+    // components()
+    // Returns the dense arrays every Actor in this world keeps its
+    // simulation state in; see ActorComponents.h.
+    ActorComponents& components();
+    const ActorComponents& components() const;
+    
+    // tickProfiler()
+    // Returns the per-phase timing for move(). Off until someone calls
+    // setEnabled(true) on it; see TickProfiler.h.
+    TickProfiler& tickProfiler();
+    const TickProfiler& tickProfiler() const;
+    
+    // setUpdateThreads(int threads)
+    // 1 (the default) updates every actor one after another, each seeing
+    // everything the ones before it did. Any other value switches to a
+    // two-phase update on that many threads (0 = one per core):
+    //   1. Everything but the bacteria updates in order, as usual.
+    //   2. The bacteria update in parallel against the world as it stands.
+    //      They move and turn themselves, but their effects on everything
+    //      else are recorded instead of applied: damage to Socrates, food
+    //      eaten and offspring.
+    //   3. Those effects are committed one bacterium at a time, in update
+    //      order. If two bacteria went for the same Food, the first one gets
+    //      it and the other goes hungry this tick. Offspring start next tick.
+    // A two-phase game plays out the same for every thread count, but not
+    // the same as a one-thread game. Also settable with the
+    // KONTAGION_THREADS environment variable. All the worlds in a process
+    // share one worker per core between them (see WorkerPool), so a world
+    // may get fewer threads than asked for; it still plays out the same.
+    void setUpdateThreads(int threads);
+    
+    // getUpdateThreads()
+    // Returns how many threads move() currently uses.
+    int getUpdateThreads() const;
+    
+    // isDeferringEffects()
+    // True while the bacteria run their parallel phase, when they have to
+    // record their effects instead of applying them.
+    bool isDeferringEffects() const;
+    
+    // actorMoved(Actor* actor)
+    // Called by Actor::moveTo so the spatial grid can re-bucket the actor.
+    void actorMoved(Actor* actor);
+    
     // isBacteriumMovementBlockedAt(Actor* actor, double x, double y)
     // Returns true if Bacterium will be blocked at (x,y)
     bool isBacteriumMovementBlockedAt(double x, double y) const;
@@ -33,6 +145,10 @@ public:
     // Returns an edible Actor* if it exists, otherwise nullptr.
     Actor* getOverlappingEdible(Actor* overlappingActor) const;
     
+    // getSocrates()
+    // Returns this world's Socrates, or nullptr between levels.
+    Socrates* getSocrates() const;
+    
     // getOverlappingSocrates(Actor* overlappingActor)
     // Returns Socrates if some dunderhead collides wid da BOI
     Socrates* getOverlappingSocrates(Actor* overlappingActor) const;
@@ -46,47 +162,175 @@ public:
     // direction from actor a to the socrates.
     bool getAngleToNearbySocrates(Actor* a, int dist, int& angle) const;
     
+    // getPursuitAngleToSocrates(Actor* a, int dist, int& angle, bool& routed)
+    // Same test, but angle is the way to head to reach socrates around
+    // the dirt in between, taken from this tick's PursuitField, and routed
+    // is true. Falls back to the straight line, with routed false, when a is
+    // next to socrates or walled off.
+    bool getPursuitAngleToSocrates(Actor* a, int dist, int& angle, bool& routed) const;
+    
     // getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle)
     // Return true if there is a living edible object within the indicated
     // distance from actor a; otherwise false.  If true, angle will be set
     // to the direction from actor a to the edible object nearest to it
     bool getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle) const;
     
+    // EdibleTarget
+    // The result of one nearest-edible search, kept by the actor that asked
+    // so that asking again can often skip the search.
+    struct EdibleTarget
+    {
+        double x = 0, y = 0;            // where the search was made from
+        int dist = -1;                  // how far it looked; -1 = nothing kept yet
+        long insertions = 0;            // how many edibles had been added by then
+        ActorComponents::Ref food;      // the nearest one; handle -1 = none in range
+        double distance = 0;            // how far away it is (dist if none)
+    };
+    
+    // getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle, EdibleTarget& target)
+    // Same, but reuses target instead of searching when a hasn't moved since
+    // it was filled in, the edible it names hasn't been removed, and no edible
+    // added since is strictly closer (a later one loses a tie, having a higher
+    // ID). Otherwise searches and refills target. The answer is always the
+    // same as a fresh search.
+    bool getAngleToNearestNearbyEdible(Actor* a, int dist, int& angle, EdibleTarget& target) const;
+    
 private:
+    // Declared first so they outlive every Actor allocated from the pool
+    // and holding a slot in the component store.
+    ActorPool pool;
+    ActorComponents componentStore;
+    
+    // The populations a query or the update loop may need to look at.
+    // Every Actor except Socrates lives in exactly one of these.
+    enum ActorCategory
+    {
+        BLOCKERS, EDIBLES, BACTERIA, PROJECTILES, GOODIES, PITS, NUM_CATEGORIES
+    };
+    
     Socrates* socrates;
+    RandomGenerator rng;
+    std::uint64_t seed;
+    long tick;
+    mutable TickProfiler profiler;  // the const queries still get counted
+    HudText hud;
+    
+    // Actors whose doSomething() has to run each tick, in the order they were added.
+    // Dirt and Food do nothing, so they are left out.
     std::vector<Actor*> actors;
     
+    // Every Actor, filed by category. These own the Actors.
+    std::vector<Actor*> categories[NUM_CATEGORIES];
+    
+    // Broad phase for the proximity queries above, one per category
+    // that gets queried by position; see SpatialGrid.h.
+    SpatialGrid grids[NUM_CATEGORIES];
+    int nextActorID;
+    
+    // Which pixels of the dish the BLOCKERS and the dish edge block, for
+    // isBacteriumMovementBlockedAt(). Kept in step with grids[BLOCKERS].
+    BlockingRaster blocking;
+    
+    // Routes from everywhere in the dish to Socrates around the BLOCKERS.
+    // Brought up to date once a tick, after Socrates has moved.
+    PursuitField pursuit;
+    
+    // Where the last EDIBLE_LOG_SIZE edibles were added, for checking an
+    // EdibleTarget against them. Entry i % EDIBLE_LOG_SIZE is the i-th.
+    static const int EDIBLE_LOG_SIZE = 64;
+    double edibleLogX[EDIBLE_LOG_SIZE];
+    double edibleLogY[EDIBLE_LOG_SIZE];
+    long edibleInsertions;
+    
+    // Two-phase update; workers is null while move() runs one thread.
+    std::unique_ptr<WorkerPool> workers;
+    std::vector<Actor*> bacteriaBatch;
+    bool deferringEffects;
+    
+    // The init() status of a level prepareNextLevel() is working on.
+    std::future<int> preparedLevel;
+    
+    // The one thread prepareNextLevel() hands its work to. Started the first
+    // time it is needed and kept until the world is destroyed.
+    std::thread loader;
+    std::mutex loaderMutex;
+    std::condition_variable loaderWake;
+    std::packaged_task<int()> loaderTask;   // empty while there's nothing to do
+    bool loaderStopping;
+    
+    // loaderLoop()
+    // Body of the loader thread: runs each loaderTask as it is handed over.
+    void loaderLoop();
+    
+    // initLevel() / cleanUpLevel()
+    // What init() and cleanUp() do when no level has been prepared.
+    int initLevel();
+    void cleanUpLevel();
+    
+    // discardLevel()
+    // Destroys the level in progress like cleanUpLevel(), but frees each
+    // actor on its own and keeps the pool and component arrays, so actors
+    // built for the next level before this one went (see restoreSnapshot())
+    // are left alone.
+    void discardLevel();
+    
+    // forgetLevel()
+    // Empties the containers and indexes of a level whose actors have all
+    // been destroyed.
+    void forgetLevel();
+    
+    // categoryOf(ActorType type)
+    // Returns the category an Actor of this type is filed under.
+    static ActorCategory categoryOf(ActorType type);
+    
+    // isStatic(ActorCategory category)
+    // Returns true if Actors of this category never do anything on their own.
+    static bool isStatic(ActorCategory category);
+    
+    // isIndexed(ActorCategory category)
+    // Returns true if Actors of this category are kept in a spatial grid.
+    static bool isIndexed(ActorCategory category);
+    
+    // updateActor(Actor* actor)
+    // Runs actor->doSomething(), timed per class while profiling.
+    void updateActor(Actor* actor);
+    
+    // updateActorsInPhases()
+    // The two-phase update described at setUpdateThreads().
+    // Returns how many actors were updated.
+    int updateActorsInPhases();
+    
+    // removeDeadActors()
+    // Deletes every dead Actor in one linear pass over each container.
+    // Returns how many were deleted.
+    int removeDeadActors();
+    
     // sstream()
-    // Prints text to screen
+    // Refreshes the status line and hands it to the controller.
+    // It is only re-formatted when one of its fields changed.
     void sstream();
     
     void addGoodies();
-    // NOTE: THE FOLLOWING FUNCTIONS SHOULD BE CALLED IN THEIR RESPECTIVE ORDERS BELOW
-    
-    // addPits()
-    // Populates the StudentWorld with Pits as long as
-    // there are no existing actors in our actors container.
-    // Therefore, this MUST be called before our other populator functions.
-    void addPits();
     
-    // addFood()
-    // Populates the StudentWorld with Food that
-    // does not overlap with existing Pits or each other
-    void addFood();
+    // addPits(const LevelLayout& layout) / addFood(...) / addDirt(...)
+    // Create the level's Pits, Food and Dirt where layout put them.
+    void addPits(const LevelLayout& layout);
+    void addFood(const LevelLayout& layout);
+    void addDirt(const LevelLayout& layout);
     
-    // addDirt()
-    // Populates the StudentWorld with Dirt that
-    // does not overlap with existing Pits or edible Actors
-    void addDirt();
+    // createActor(ActorType type, double x, double y)
+    // Returns a new Actor of type at (x,y) with its constructor's defaults,
+    // not yet added, for restoreSnapshot() to fill in. Socrates is made by
+    // initLevel() and restoreSnapshot() themselves.
+    Actor* createActor(ActorType type, double x, double y);
     
     // overlap(Actor* actor1, Actor* actor2)
     // Returns true if actor1 and actor2 are equal to or less than 8 pixels apart
     bool overlap(Actor* actor1, Actor* actor2) const;
     
-    // getPositionInViewRadius(double& x, double&y)
-    // Returns a position whose distance is <= 120px from the
-    // center of the circle using the x and y REFERENCES
-    void getPositionInViewRadius(double& x, double&y) const;
+    // isTargetCurrent(Actor* a, int dist, const EdibleTarget& target)
+    // Returns true if target still answers a nearest-edible search by a.
+    bool isTargetCurrent(Actor* a, int dist, const EdibleTarget& target) const;
 };
 
 #endif // STUDENTWORLD_H_
@@ -0,0 +1,245 @@
+#include "TickProfiler.h"
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+TickProfiler::TickProfiler()
+{
+    m_enabled = false;
+    m_dumpOnExit = false;
+    m_current = Sample();
+    reset();
+}
+
+TickProfiler::~TickProfiler()
+{
+    if (m_dumpOnExit && m_totalTicks > 0)
+        dump(cerr);
+}
+
+void TickProfiler::setEnabled(bool enabled)
+{
+    if (enabled && !m_enabled)
+    {
+        m_window.resize(WINDOW);
+        reset();
+    }
+    m_enabled = enabled;
+}
+
+bool TickProfiler::isEnabled() const
+{
+    return m_enabled;
+}
+
+void TickProfiler::setDumpOnExit(bool dump)
+{
+    m_dumpOnExit = dump;
+}
+
+void TickProfiler::reset()
+{
+    m_next = 0;
+    m_size = 0;
+    m_totalTicks = 0;
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        m_nanoSums[p] = 0;
+        for (int b = 0; b < NUM_BUCKETS; b++)
+            m_buckets[p][b] = 0;
+    }
+    for (int c = 0; c < NUM_COUNTS; c++)
+    {
+        m_countSums[c] = 0;
+        m_countTotals[c] = 0;
+    }
+    for (int t = 0; t <= NUM_ACTOR_TYPES; t++)
+        m_classes[t] = ClassCost();
+    m_actorClass = WORLD;
+}
+
+void TickProfiler::endTick(int updated, int spawned, int died)
+{
+    if (!m_enabled) return;
+    m_current.counts[UPDATED] = updated;
+    m_current.counts[SPAWNED] = spawned;
+    m_current.counts[DIED] = died;
+
+    // Once the ring is full the oldest tick falls out of the window.
+    if (m_size == WINDOW)
+        add(m_window[m_next], -1);
+    else
+        m_size++;
+    m_window[m_next] = m_current;
+    add(m_current, 1);
+    m_next = (m_next + 1) % WINDOW;
+
+    m_totalTicks++;
+    for (int c = 0; c < NUM_COUNTS; c++)
+        m_countTotals[c] += m_current.counts[c];
+}
+
+void TickProfiler::add(const Sample& sample, int sign)
+{
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        m_nanoSums[p] += sign * sample.nanos[p];
+        m_buckets[p][bucketOf(sample.nanos[p])] += sign;
+    }
+    for (int c = 0; c < NUM_COUNTS; c++)
+        m_countSums[c] += sign * sample.counts[c];
+}
+
+int TickProfiler::bucketOf(int64_t nanos)
+{
+    int bucket = 0;
+    while (nanos > 1 && bucket < NUM_BUCKETS - 1)
+    {
+        nanos >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+int TickProfiler::ticks() const
+{
+    return m_size;
+}
+
+long TickProfiler::totalTicks() const
+{
+    return m_totalTicks;
+}
+
+int64_t TickProfiler::last(Phase phase) const
+{
+    if (m_size == 0) return 0;
+    return m_window[(m_next + WINDOW - 1) % WINDOW].nanos[phase];
+}
+
+int TickProfiler::last(Count count) const
+{
+    if (m_size == 0) return 0;
+    return m_window[(m_next + WINDOW - 1) % WINDOW].counts[count];
+}
+
+double TickProfiler::mean(Phase phase) const
+{
+    return m_size == 0 ? 0 : double(m_nanoSums[phase]) / m_size;
+}
+
+double TickProfiler::mean(Count count) const
+{
+    return m_size == 0 ? 0 : double(m_countSums[count]) / m_size;
+}
+
+long TickProfiler::total(Count count) const
+{
+    return m_countTotals[count];
+}
+
+int64_t TickProfiler::percentile(Phase phase, double p) const
+{
+    if (m_size == 0) return 0;
+    long rank = static_cast<long>(p / 100 * m_size);
+    if (rank >= m_size) rank = m_size - 1;
+    long seen = 0;
+    for (int b = 0; b < NUM_BUCKETS; b++)
+    {
+        seen += m_buckets[phase][b];
+        if (seen > rank)
+            return int64_t(2) << b;
+    }
+    return int64_t(2) << (NUM_BUCKETS - 1);
+}
+
+long TickProfiler::classUpdates(ActorType type) const
+{
+    return m_classes[static_cast<int>(type)].updates;
+}
+
+int64_t TickProfiler::classNanos(ActorType type) const
+{
+    return m_classes[static_cast<int>(type)].nanos;
+}
+
+long TickProfiler::classQueries(ActorType type) const
+{
+    return m_classes[static_cast<int>(type)].queries;
+}
+
+long TickProfiler::worldQueries() const
+{
+    return m_classes[WORLD].queries;
+}
+
+const long* TickProfiler::histogram(Phase phase) const
+{
+    return m_buckets[phase];
+}
+
+void TickProfiler::dump(ostream& out) const
+{
+    out << "tick profile: last " << m_size << " of " << m_totalTicks << " ticks" << endl;
+    out << setw(12) << left << "phase" << right << setw(12) << "mean us" << setw(12) << "p50 us"
+        << setw(12) << "p99 us" << setw(12) << "last us" << endl;
+    out << fixed << setprecision(2);
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        Phase phase = static_cast<Phase>(p);
+        out << setw(12) << left << phaseName(phase) << right << setw(12) << mean(phase) / 1000
+            << setw(12) << percentile(phase, 50) / 1000.0 << setw(12) << percentile(phase, 99) / 1000.0
+            << setw(12) << last(phase) / 1000.0 << endl;
+    }
+    out << setw(12) << left << "count" << right << setw(12) << "mean/tick" << setw(12) << "total"
+        << setw(12) << "last" << endl;
+    for (int c = 0; c < NUM_COUNTS; c++)
+    {
+        Count count = static_cast<Count>(c);
+        out << setw(12) << left << countName(count) << right << setw(12) << mean(count)
+            << setw(12) << total(count) << setw(12) << last(count) << endl;
+    }
+
+    // Class costs cover every tick since the last reset, not just the window.
+    double ticks = m_totalTicks > 0 ? m_totalTicks : 1;
+    out << setw(22) << left << "class" << right << setw(12) << "inst/tick" << setw(12) << "us/inst"
+        << setw(12) << "us/tick" << setw(12) << "qry/inst" << setw(12) << "qry/tick" << endl;
+    for (int t = 0; t < NUM_ACTOR_TYPES; t++)
+    {
+        const ClassCost& cost = m_classes[t];
+        if (cost.updates == 0 && cost.queries == 0)
+            continue;
+        double updates = cost.updates > 0 ? cost.updates : 1;
+        out << setw(22) << left << actorTypeName(static_cast<ActorType>(t)) << right
+            << setw(12) << cost.updates / ticks << setw(12) << cost.nanos / updates / 1000
+            << setw(12) << cost.nanos / ticks / 1000 << setw(12) << cost.queries / updates
+            << setw(12) << cost.queries / ticks << endl;
+    }
+    out << setw(22) << left << "(world)" << right << setw(12) << "" << setw(12) << "" << setw(12) << ""
+        << setw(12) << "" << setw(12) << m_classes[WORLD].queries / ticks << endl;
+    out << defaultfloat;
+}
+
+const char* TickProfiler::phaseName(Phase phase)
+{
+    switch (phase)
+    {
+        case GOODIES:       return "goodies";
+        case SOCRATES:      return "socrates";
+        case ACTORS:        return "actors";
+        case REMOVE_DEAD:   return "removeDead";
+        case HUD:           return "hud";
+        default:            return "?";
+    }
+}
+
+const char* TickProfiler::countName(Count count)
+{
+    switch (count)
+    {
+        case UPDATED:   return "updated";
+        case SPAWNED:   return "spawned";
+        case DIED:      return "died";
+        default:        return "?";
+    }
+}
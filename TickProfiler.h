@@ -0,0 +1,208 @@
+#ifndef TICKPROFILER_H_
+#define TICKPROFILER_H_
+
+#include "ActorType.h"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// TickProfiler
+// Per-phase timing for StudentWorld::move(). Each tick is split into the
+// phases below; the profiler keeps the last WINDOW ticks of phase times and
+// per-tick counts, plus a log2 histogram per phase over that same window, so
+// percentiles always describe recent ticks rather than the whole game.
+// Within the actor phases it also attributes update time and spatial query
+// counts to each concrete Actor class, accumulated since the last reset.
+// It is off by default; setting the KONTAGION_PROFILE environment variable
+// turns it on for every StudentWorld and dumps the profile on exit. While
+// disabled every call is a single branch and no memory is allocated, so it
+// can stay compiled into every build.
+class TickProfiler
+{
+public:
+    enum Phase
+    {
+        GOODIES,        // addGoodies()
+        SOCRATES,       // socrates->doSomething()
+        ACTORS,         // the update loop over every other actor
+        REMOVE_DEAD,    // removeDeadActors()
+        HUD,            // building the status line
+        NUM_PHASES
+    };
+
+    enum Count
+    {
+        UPDATED,        // doSomething() calls, Socrates included
+        SPAWNED,        // actors added during the tick
+        DIED,           // actors removed at the end of the tick
+        NUM_COUNTS
+    };
+
+    static const int WINDOW = 1024;
+    static const int NUM_BUCKETS = 40;  // bucket b holds times in [2^b, 2^(b+1)) ns
+
+    TickProfiler();
+    ~TickProfiler();
+
+    // setEnabled(bool enabled)
+    // Starts or stops collecting. Turning it on clears whatever was collected.
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // setDumpOnExit(bool dump)
+    // If set, the profile is printed to std::cerr when the profiler is
+    // destroyed, i.e. when its world goes away.
+    void setDumpOnExit(bool dump);
+
+    // reset()
+    // Forgets every tick collected so far.
+    void reset();
+
+    // beginTick()
+    // Starts timing a tick; the first phase starts now.
+    void beginTick()
+    {
+        if (!m_enabled) return;
+        m_phaseStart = Clock::now();
+    }
+
+    // endPhase(Phase phase)
+    // Ends the phase that is running; the next phase starts now.
+    void endPhase(Phase phase)
+    {
+        if (!m_enabled) return;
+        Clock::time_point now = Clock::now();
+        m_current.nanos[phase] = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_phaseStart).count();
+        m_phaseStart = now;
+    }
+
+    // beginActor(ActorType type)
+    // Starts timing one actor's doSomething(). Queries made until endActor()
+    // are charged to its class.
+    void beginActor(ActorType type)
+    {
+        if (!m_enabled) return;
+        m_actorClass = static_cast<int>(type);
+        m_actorStart = Clock::now();
+    }
+
+    // endActor()
+    // Charges the time since beginActor() to that actor's class.
+    void endActor()
+    {
+        if (!m_enabled) return;
+        ClassCost& cost = m_classes[m_actorClass];
+        cost.nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_actorStart).count();
+        cost.updates++;
+        m_actorClass = WORLD;
+    }
+
+    // countQuery()
+    // Counts one spatial query against the actor being updated, or against
+    // the world itself when no actor is (level setup, goodie spawning).
+    void countQuery()
+    {
+        if (!m_enabled) return;
+        m_classes[m_actorClass].queries++;
+    }
+
+    // endTick(int updated, int spawned, int died)
+    // Files the tick's phase times and counts into the window.
+    void endTick(int updated, int spawned, int died);
+
+    // ticks()
+    // Returns how many ticks are in the window (at most WINDOW).
+    int ticks() const;
+
+    // totalTicks()
+    // Returns how many ticks have been collected since the last reset.
+    long totalTicks() const;
+
+    // last(Phase phase) / last(Count count)
+    // Returns the most recent tick's value (nanoseconds for phases).
+    std::int64_t last(Phase phase) const;
+    int last(Count count) const;
+
+    // mean(Phase phase) / mean(Count count)
+    // Returns the average over the window (nanoseconds for phases).
+    double mean(Phase phase) const;
+    double mean(Count count) const;
+
+    // total(Count count)
+    // Returns the sum of a count since the last reset.
+    long total(Count count) const;
+
+    // percentile(Phase phase, double p)
+    // Returns an upper bound, in nanoseconds, on the p-th percentile
+    // (0 to 100) of the phase's times in the window. The bound is the top of
+    // the histogram bucket the percentile falls in, so it is within 2x.
+    std::int64_t percentile(Phase phase, double p) const;
+
+    // classUpdates(ActorType type) / classNanos(ActorType type) / classQueries(ActorType type)
+    // Return how many times the class's actors were updated, the nanoseconds
+    // spent updating them and the spatial queries they made, since the last reset.
+    long classUpdates(ActorType type) const;
+    std::int64_t classNanos(ActorType type) const;
+    long classQueries(ActorType type) const;
+
+    // worldQueries()
+    // Returns the spatial queries made outside any actor's update since the last reset.
+    long worldQueries() const;
+
+    // histogram(Phase phase)
+    // Returns the phase's NUM_BUCKETS bucket counts over the window.
+    const long* histogram(Phase phase) const;
+
+    // dump(std::ostream& out)
+    // Prints a table of every phase and count over the window, then the
+    // cost of each Actor class per instance and per tick.
+    void dump(std::ostream& out) const;
+
+    static const char* phaseName(Phase phase);
+    static const char* countName(Count count);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Sample
+    {
+        std::int64_t nanos[NUM_PHASES];
+        int counts[NUM_COUNTS];
+    };
+
+    struct ClassCost
+    {
+        long updates;
+        std::int64_t nanos;
+        long queries;
+    };
+
+    static const int WORLD = NUM_ACTOR_TYPES;   // queries made outside actor updates
+
+    bool m_enabled;
+    bool m_dumpOnExit;
+    Clock::time_point m_phaseStart;
+    Sample m_current;
+
+    // Ring of the last WINDOW samples; only allocated once enabled.
+    std::vector<Sample> m_window;
+    int m_next;
+    int m_size;
+    long m_totalTicks;
+
+    // Running sums over the window, kept in step with m_window.
+    std::int64_t m_nanoSums[NUM_PHASES];
+    long m_countSums[NUM_COUNTS];
+    long m_countTotals[NUM_COUNTS];
+    long m_buckets[NUM_PHASES][NUM_BUCKETS];
+
+    ClassCost m_classes[NUM_ACTOR_TYPES + 1];
+    int m_actorClass;
+    Clock::time_point m_actorStart;
+
+    static int bucketOf(std::int64_t nanos);
+    void add(const Sample& sample, int sign);
+};
+
+#endif // TICKPROFILER_H_
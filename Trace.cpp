@@ -0,0 +1,165 @@
+#include "Trace.h"
+#include <fstream>
+#include <iomanip>
+using namespace std;
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        const char* category;
+        int64_t start;
+        int64_t duration;
+        int64_t arg;
+    };
+
+    // One per thread that is recording zones. Only the owning thread writes
+    // events; count is published with release so an exporter that reads it
+    // with acquire sees every event before it. Buffers are never freed: a
+    // thread that exits gives its buffer back, and its zones can still be
+    // exported until the next thread to start recording takes it over. So
+    // there are only ever as many buffers as threads recording at once.
+    struct ThreadBuffer
+    {
+        Event events[Trace::EVENTS_PER_THREAD];
+        atomic<uint64_t> count;
+        atomic<const char*> name;
+        atomic<bool> inUse;
+        int tid;
+        ThreadBuffer* next;
+    };
+
+    // Registered buffers, newest first. Threads push themselves on with a
+    // compare-and-swap, so registering doesn't take a lock either.
+    atomic<ThreadBuffer*> s_buffers(nullptr);
+    atomic<int> s_nextTid(1);
+    const chrono::steady_clock::time_point s_epoch = chrono::steady_clock::now();
+
+    // The calling thread's buffer, if it has recorded anything, and the
+    // name it was given. The buffer goes back to the list when the thread exits.
+    struct BufferLease
+    {
+        ThreadBuffer* buffer = nullptr;
+
+        ~BufferLease()
+        {
+            if (buffer != nullptr)
+                buffer->inUse.store(false, memory_order_release);
+        }
+    };
+
+    thread_local BufferLease t_lease;
+    thread_local const char* t_name = nullptr;
+
+    ThreadBuffer* threadBuffer()
+    {
+        if (t_lease.buffer != nullptr)
+            return t_lease.buffer;
+
+        // Take over the buffer of a thread that has exited, if there is one.
+        ThreadBuffer* buffer = s_buffers.load(memory_order_acquire);
+        for (; buffer != nullptr; buffer = buffer->next)
+        {
+            bool expected = false;
+            if (!buffer->inUse.load(memory_order_relaxed)
+                && buffer->inUse.compare_exchange_strong(expected, true, memory_order_acquire))
+                break;
+        }
+
+        if (buffer == nullptr)
+        {
+            buffer = new ThreadBuffer;
+            buffer->count.store(0, memory_order_relaxed);
+            buffer->name.store(t_name, memory_order_relaxed);
+            buffer->inUse.store(true, memory_order_relaxed);
+            buffer->tid = s_nextTid++;
+            buffer->next = s_buffers.load(memory_order_relaxed);
+            while (!s_buffers.compare_exchange_weak(buffer->next, buffer, memory_order_release, memory_order_relaxed))
+                ;
+        }
+        else
+        {
+            // The last owner's zones go with it.
+            buffer->count.store(0, memory_order_release);
+            buffer->name.store(t_name, memory_order_release);
+        }
+        t_lease.buffer = buffer;
+        return buffer;
+    }
+}
+
+atomic<bool> Trace::s_enabled(false);
+
+void Trace::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, memory_order_relaxed);
+}
+
+void Trace::setThreadName(const char* name)
+{
+    // A thread that hasn't recorded yet picks the name up when it does.
+    t_name = name;
+    if (t_lease.buffer != nullptr)
+        t_lease.buffer->name.store(name, memory_order_release);
+}
+
+chrono::steady_clock::time_point Trace::epoch()
+{
+    return s_epoch;
+}
+
+void Trace::record(const char* name, const char* category, int64_t start, int64_t duration, int64_t arg)
+{
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t n = buffer->count.load(memory_order_relaxed);
+    Event& e = buffer->events[n % EVENTS_PER_THREAD];
+    e.name = name;
+    e.category = category;
+    e.start = start;
+    e.duration = duration;
+    e.arg = arg;
+    buffer->count.store(n + 1, memory_order_release);
+}
+
+void Trace::writeChromeJson(ostream& out)
+{
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << fixed << setprecision(3);
+    bool first = true;
+    for (ThreadBuffer* buffer = s_buffers.load(memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+    {
+        const char* threadName = buffer->name.load(memory_order_acquire);
+        if (threadName != nullptr)
+        {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->tid << ",\"args\":{\"name\":\"" << threadName << "\"}}";
+            first = false;
+        }
+
+        uint64_t count = buffer->count.load(memory_order_acquire);
+        uint64_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+        for (uint64_t i = begin; i < count; i++)
+        {
+            const Event& e = buffer->events[i % EVENTS_PER_THREAD];
+            out << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << e.duration / 1000.0;
+            if (e.arg >= 0)
+                out << ",\"args\":{\"count\":" << e.arg << "}";
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    out << defaultfloat;
+}
+
+bool Trace::writeChromeJson(string path)
+{
+    ofstream ofs(path);
+    if (!ofs)
+        return false;
+    writeChromeJson(ofs);
+    return static_cast<bool>(ofs);
+}
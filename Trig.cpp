@@ -0,0 +1,58 @@
+#include "Trig.h"
+#include <cmath>
+
+const double Trig::PI = 4 * std::atan(1.0);
+double Trig::s_cos[360];
+double Trig::s_sin[360];
+Trig::TableBuilder Trig::s_builder;
+
+Trig::TableBuilder::TableBuilder()
+{
+    for (int d = 0; d < 360; d++)
+    {
+        s_cos[d] = computeCos(d);
+        s_sin[d] = computeSin(d);
+    }
+}
+
+double Trig::computeCos(int degrees)
+{
+    // Same expression GraphObject::moveAngle has always used.
+    return std::cos(degrees * 1.0 / 360 * 2 * (4 * std::atan(1.0)));
+}
+
+double Trig::computeSin(int degrees)
+{
+    return std::sin(degrees * 1.0 / 360 * 2 * (4 * std::atan(1.0)));
+}
+
+int Trig::atan2Degrees(double y, double x)
+{
+    // Estimate the angle with a polynomial good to about 1e-5 radians
+    // (0.0006 degrees). When the estimate is clearly between two whole
+    // degrees its truncation is the answer; only when it lands within
+    // MARGIN of a whole degree (or anything is zero, infinite or NaN) do we
+    // pay for atan2 to get the exact same truncation as before.
+    const double MARGIN = 0.002;
+    double ax = std::fabs(x), ay = std::fabs(y);
+    if (ax == 0 || ay == 0 || !std::isfinite(ax) || !std::isfinite(ay))
+        return static_cast<int>(std::atan2(y, x) * 180 / PI);
+
+    bool swapped = ay > ax;
+    double z = swapped ? ax / ay : ay / ax;     // in (0, 1]
+    double z2 = z * z;
+    double a = z * (0.9998660 + z2 * (-0.3302995 + z2 * (0.1801410 + z2 * (-0.0851330 + z2 * 0.0208351))));
+    if (swapped)
+        a = PI / 2 - a;
+    if (x < 0)
+        a = PI - a;
+    if (y < 0)
+        a = -a;
+
+    double degrees = a * 180 / PI;
+    double whole = std::trunc(degrees);
+    double fraction = std::fabs(degrees - whole);
+    if (fraction < MARGIN || fraction > 1 - MARGIN)
+        return static_cast<int>(std::atan2(y, x) * 180 / PI);
+    return static_cast<int>(whole);
+}
@@ -0,0 +1,56 @@
+#ifndef TRIG_H_
+#define TRIG_H_
+
+// Trig
+// Angle math for whole-degree angles, shared by the simulation and the
+// renderer. Every Direction in the game is a whole number of degrees, so
+// sine and cosine come from a 360-entry table instead of libm, and
+// atan2Degrees() finds the whole-degree direction between two points
+// without calling atan2 in the common case.
+//
+// The table holds exactly what cos(d / 360.0 * 2 * PI) and its sine
+// counterpart evaluate to, so moving by table gives bit-for-bit the same
+// positions as computing the trig on the spot.
+class Trig
+{
+public:
+    static const double PI;
+
+    // cosDegrees(int degrees) / sinDegrees(int degrees)
+    // Cosine and sine of a whole-degree angle. Angles outside [0, 360) are
+    // computed directly so they match the untabled expression exactly.
+    static double cosDegrees(int degrees)
+    {
+        if (degrees >= 0 && degrees < 360)
+            return s_cos[degrees];
+        return computeCos(degrees);
+    }
+
+    static double sinDegrees(int degrees)
+    {
+        if (degrees >= 0 && degrees < 360)
+            return s_sin[degrees];
+        return computeSin(degrees);
+    }
+
+    // atan2Degrees(double y, double x)
+    // Returns static_cast<int>(atan2(y, x) * 180 / PI), the direction from
+    // the origin to (x,y) truncated toward zero, in (-180, 180].
+    static int atan2Degrees(double y, double x);
+
+private:
+    static double s_cos[360];
+    static double s_sin[360];
+
+    static double computeCos(int degrees);
+    static double computeSin(int degrees);
+
+    // Fills the tables before main() runs.
+    struct TableBuilder
+    {
+        TableBuilder();
+    };
+    static TableBuilder s_builder;
+};
+
+#endif // TRIG_H_
@@ -0,0 +1,125 @@
+#include "WorkerPool.h"
+#include "Trace.h"
+#include <algorithm>
+using namespace std;
+
+atomic<int> WorkerPool::s_workersInUse(0);
+
+int WorkerPool::workerBudget()
+{
+    return max(1, static_cast<int>(thread::hardware_concurrency())) - 1;
+}
+
+WorkerPool::WorkerPool(int threads)
+{
+    int wanted = max(threads, 1) - 1;
+    int inUse = s_workersInUse.load();
+    int granted;
+    do
+        granted = max(0, min(wanted, workerBudget() - inUse));
+    while (!s_workersInUse.compare_exchange_weak(inUse, inUse + granted));
+    m_size = 1 + granted;
+    m_shares.reset(new Share[m_size]);
+    for (int i = 0; i < m_size; i++)
+    {
+        m_shares[i].next.store(0);
+        m_shares[i].end = 0;
+    }
+    m_body = nullptr;
+    m_grain = 1;
+    m_generation = 0;
+    m_running = 0;
+    m_stopping = false;
+
+    for (int i = 1; i < m_size; i++)
+        m_threads.emplace_back(&WorkerPool::workerLoop, this, i);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_threads.size(); i++)
+        m_threads[i].join();
+    s_workersInUse -= m_size - 1;
+}
+
+int WorkerPool::size() const
+{
+    return m_size;
+}
+
+void WorkerPool::parallelFor(int n, int grain, const function<void(int, int)>& body)
+{
+    if (n <= 0)
+        return;
+    grain = max(grain, 1);
+
+    // Not worth waking anybody for a single chunk.
+    if (m_size == 1 || n <= grain)
+    {
+        body(0, n);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        for (int i = 0; i < m_size; i++)
+        {
+            m_shares[i].next.store(static_cast<int>(static_cast<long>(n) * i / m_size), memory_order_relaxed);
+            m_shares[i].end = static_cast<int>(static_cast<long>(n) * (i + 1) / m_size);
+        }
+        m_body = &body;
+        m_grain = grain;
+        m_running = m_size - 1;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    runShares(0);
+
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_running == 0; });
+    m_body = nullptr;
+}
+
+void WorkerPool::workerLoop(int index)
+{
+    // Picked up by this thread's first traced zone, whenever tracing is on.
+    Trace::setThreadName("worker");
+    long seen = 0;
+    unique_lock<mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+        if (m_stopping)
+            return;
+        seen = m_generation;
+
+        lock.unlock();
+        runShares(index);
+        lock.lock();
+
+        if (--m_running == 0)
+            m_done.notify_one();
+    }
+}
+
+void WorkerPool::runShares(int first)
+{
+    const function<void(int, int)>& body = *m_body;
+    for (int k = 0; k < m_size; k++)
+    {
+        Share& share = m_shares[(first + k) % m_size];
+        for (;;)
+        {
+            int begin = share.next.fetch_add(m_grain, memory_order_relaxed);
+            if (begin >= share.end)
+                break;
+            body(begin, min(begin + m_grain, share.end));
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// WorkerPool
+// A fixed set of threads for splitting one loop across cores. parallelFor()
+// gives every thread (the caller included) an equal share of the range;
+// each thread works through its own share a chunk at a time and then steals
+// chunks from the shares of threads that are still busy, so one slow share
+// doesn't hold up the rest.
+class WorkerPool
+{
+public:
+    // WorkerPool(int threads)
+    // Starts up to threads - 1 worker threads; the thread calling
+    // parallelFor() does the remaining share itself. A pool of one runs
+    // everything inline. Every pool in the process draws its workers from
+    // one budget of a worker per core beyond the first, so many worlds
+    // running side by side (see BatchRunner) don't start more threads than
+    // there are cores; a pool that finds the budget spent gets fewer
+    // workers, down to none, until other pools give theirs back.
+    explicit WorkerPool(int threads);
+    ~WorkerPool();
+
+    // size()
+    // Returns how many threads share each loop, the caller included, which
+    // is fewer than asked for if the budget ran short.
+    int size() const;
+
+    // parallelFor(int n, int grain, const std::function<void(int, int)>& body)
+    // Calls body(begin, end) on disjoint chunks of at most grain indices that
+    // together cover [0, n), and returns once every chunk is done. Chunks run
+    // concurrently and in no particular order. body must not call parallelFor().
+    void parallelFor(int n, int grain, const std::function<void(int, int)>& body);
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+private:
+    // One thread's part of the range. Owner and thieves both claim chunks
+    // by bumping next. Padded so neighbouring shares don't share a cache line.
+    struct alignas(64) Share
+    {
+        std::atomic<int> next;
+        int end;
+    };
+
+    int m_size;
+    std::unique_ptr<Share[]> m_shares;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // a new loop is ready, or the pool is stopping
+    std::condition_variable m_done;     // the last worker finished the current loop
+    const std::function<void(int, int)>* m_body;
+    int m_grain;
+    long m_generation;                  // bumped once per parallelFor()
+    int m_running;                      // workers still inside the current loop
+    bool m_stopping;
+
+    // Workers started by every pool in the process, against workerBudget().
+    static std::atomic<int> s_workersInUse;
+    static int workerBudget();
+
+    void workerLoop(int index);
+
+    // runShares(int first)
+    // Drains share first, then steals from the others in turn.
+    void runShares(int first);
+};
+
+#endif // WORKERPOOL_H_
@@ -0,0 +1,27 @@
+#ifndef WORLDCONTROLLER_H_
+#define WORLDCONTROLLER_H_
+
+#include <string>
+
+// WorldController
+// Everything a GameWorld needs from whoever is running it: where key presses
+// come from and where sounds and the status line go. GameController is the
+// OpenGL/GLUT implementation; HeadlessController runs a world with no window.
+class WorldController
+{
+  public:
+    virtual ~WorldController() {}
+
+    virtual bool getLastKey(int& value) = 0;
+    virtual void playSound(int soundID) = 0;
+
+    // setGameStatText(const char* text)
+    // Hands over the status line. The world keeps text valid, and may update
+    // it in place, until it calls this again, so controllers keep the
+    // pointer instead of copying the string.
+    virtual void setGameStatText(const char* text) = 0;
+
+    virtual void quitGame() = 0;
+};
+
+#endif // WORLDCONTROLLER_H_
@@ -0,0 +1,231 @@
+// BatchRunner
+// Monte Carlo batch runner for balancing and regression runs. Plays many
+// independent StudentWorlds at once on a pool of threads, each with its own
+// seed, HeadlessController and Socrates policy, and reports per-level
+// statistics: how often a level is cleared, ticks to clear, Socrates deaths,
+// score and peak bacteria.
+//
+//   BatchRunner [--worlds N] [--threads N] [--levels N] [--ticks N] [--seed N]
+//               [--keys "left space ..."]
+//
+//   --worlds N    number of independent games to play (default 1000)
+//   --threads N   worker threads (default: every core)
+//   --levels N    stop a game after it reaches level N (default 10)
+//   --ticks N     give up on a level attempt after N ticks (default 10000)
+//   --seed N      base seed; game i uses seed + i (default 1)
+//   --keys TEXT   play every game with this key script instead of the
+//                 random policy
+//
+// Each game only touches its own world, so results are the same no matter
+// how many threads run them. Build it against the headless simulation core
+// (see README.md).
+
+#include "HeadlessController.h"
+#include "StudentWorld.h"
+#include "GameConstants.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+using namespace std;
+
+// One try at one level.
+struct LevelAttempt
+{
+    int level;
+    bool cleared;
+    bool died;
+    long ticks;
+    int scoreGained;
+    int peakBacteria;
+};
+
+struct GameResult
+{
+    vector<LevelAttempt> attempts;
+    long ticks;
+};
+
+struct BatchOptions
+{
+    int worlds = 1000;
+    int threads = 0;
+    int levels = 10;
+    long maxTicks = 10000;
+    uint64_t seed = 1;
+    bool scripted = false;
+    vector<int> keys;
+};
+
+// playGame(const BatchOptions& options, int index)
+// Plays one whole game in its own world until Socrates runs out of lives or
+// the game reaches options.levels.
+static GameResult playGame(const BatchOptions& options, int index)
+{
+    GameResult result;
+    result.ticks = 0;
+
+    HeadlessController controller;
+    if (options.scripted)
+        controller.setKeyScript(options.keys);
+    else
+        controller.setRandomPolicy(options.seed + index + 0x5eed);
+
+    StudentWorld world("");
+    world.setController(&controller);
+    world.setSeed(options.seed + index);
+
+    while (!world.isGameOver() && world.getLevel() <= options.levels)
+    {
+        LevelAttempt attempt;
+        attempt.level = world.getLevel();
+        attempt.cleared = false;
+        attempt.died = false;
+        attempt.ticks = 0;
+        attempt.peakBacteria = 0;
+        int startScore = world.getScore();
+
+        int status = world.init();
+        while (status == GWSTATUS_CONTINUE_GAME && attempt.ticks < options.maxTicks)
+        {
+            status = world.move();
+            attempt.ticks++;
+            attempt.peakBacteria = max(attempt.peakBacteria, world.getNumBacteria());
+        }
+        world.cleanUp();
+
+        attempt.cleared = (status == GWSTATUS_FINISHED_LEVEL);
+        attempt.died = (status == GWSTATUS_PLAYER_DIED);
+        attempt.scoreGained = world.getScore() - startScore;
+        result.ticks += attempt.ticks;
+        result.attempts.push_back(attempt);
+
+        if (attempt.cleared)
+            world.advanceToNextLevel();
+        else if (!attempt.died)
+            break;  // hit the tick limit; this policy isn't getting anywhere
+    }
+    return result;
+}
+
+static void usage()
+{
+    cout << "usage: BatchRunner [--worlds N] [--threads N] [--levels N] [--ticks N] [--seed N] [--keys \"left space ...\"]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    BatchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        if (arg == "--worlds")
+            options.worlds = atoi(argv[++i]);
+        else if (arg == "--threads")
+            options.threads = atoi(argv[++i]);
+        else if (arg == "--levels")
+            options.levels = atoi(argv[++i]);
+        else if (arg == "--ticks")
+            options.maxTicks = atol(argv[++i]);
+        else if (arg == "--seed")
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--keys")
+        {
+            options.scripted = true;
+            if (!HeadlessController::parseKeyScript(argv[++i], options.keys))
+            {
+                cout << "Bad key script: " << argv[i] << endl;
+                return 1;
+            }
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (options.threads <= 0)
+        options.threads = max(1u, thread::hardware_concurrency());
+
+    // Workers pull game indices off a shared counter; every game writes only
+    // its own slot in results.
+    vector<GameResult> results(options.worlds);
+    atomic<int> nextGame(0);
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < options.threads; t++)
+    {
+        workers.push_back(thread([&]()
+        {
+            for (int g = nextGame++; g < options.worlds; g = nextGame++)
+                results[g] = playGame(options, g);
+        }));
+    }
+    for (thread& worker : workers)
+        worker.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Aggregate per level.
+    struct LevelStats
+    {
+        long attempts = 0, clears = 0, deaths = 0, ticksToClear = 0;
+        long score = 0, peakBacteria = 0;
+        int maxPeakBacteria = 0;
+    };
+    vector<LevelStats> levels(options.levels + 1);
+    long totalTicks = 0, totalAttempts = 0;
+    for (const GameResult& game : results)
+    {
+        totalTicks += game.ticks;
+        for (const LevelAttempt& a : game.attempts)
+        {
+            LevelStats& s = levels[a.level];
+            s.attempts++;
+            s.deaths += a.died;
+            s.score += a.scoreGained;
+            s.peakBacteria += a.peakBacteria;
+            s.maxPeakBacteria = max(s.maxPeakBacteria, a.peakBacteria);
+            if (a.cleared)
+            {
+                s.clears++;
+                s.ticksToClear += a.ticks;
+            }
+            totalAttempts++;
+        }
+    }
+
+    cout << setw(6) << "level" << setw(10) << "attempts" << setw(8) << "clears" << setw(8) << "deaths"
+         << setw(14) << "ticks/clear" << setw(12) << "score/try" << setw(14) << "peak bact"
+         << setw(10) << "max bact" << endl;
+    cout << fixed << setprecision(1);
+    for (int l = 1; l <= options.levels; l++)
+    {
+        const LevelStats& s = levels[l];
+        if (s.attempts == 0) continue;
+        cout << setw(6) << l << setw(10) << s.attempts << setw(8) << s.clears << setw(8) << s.deaths
+             << setw(14) << (s.clears ? double(s.ticksToClear) / s.clears : 0.0)
+             << setw(12) << double(s.score) / s.attempts
+             << setw(14) << double(s.peakBacteria) / s.attempts
+             << setw(10) << s.maxPeakBacteria << endl;
+    }
+
+    cout << endl;
+    cout << "games:          " << options.worlds << endl;
+    cout << "threads:        " << options.threads << endl;
+    cout << "level attempts: " << totalAttempts << endl;
+    cout << "ticks:          " << totalTicks << endl;
+    cout << "seconds:        " << seconds << endl;
+    cout << "ticks/second:   " << (seconds > 0 ? totalTicks / seconds : 0) << endl;
+    cout << "levels/hour:    " << (seconds > 0 ? totalAttempts / seconds * 3600 : 0) << endl;
+}
@@ -0,0 +1,98 @@
+// DeathSweepBenchmark
+// Measures how long StudentWorld::move() takes as more actors die per tick.
+// With a linear dead-actor sweep the time per death stays flat no matter how
+// many actors are in the dish; with per-element vector::erase it grows with
+// both the population and the number of deaths.
+//
+// Build it against the headless simulation core (see README.md).
+
+#include "Actor.h"
+#include "StudentWorld.h"
+#include "HeadlessController.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+const int TICKS_PER_RUN = 200;
+
+// runOnce(int population, int deathsPerTick)
+// Fills a level 1 dish with population extra Dirt piles, then every tick kills
+// deathsPerTick of them and adds the same number back so the population
+// stays constant. Returns the mean wall time of move() in microseconds and
+// sets heapAllocs to how often the actor pool had to grow after the first tick.
+double runOnce(int population, int deathsPerTick, long& heapAllocs)
+{
+    HeadlessController controller;
+    StudentWorld world("");
+    world.setController(&controller);
+    world.setSeed(1);
+    world.init();
+
+    vector<Dirt*> piles;
+    int next = 0;
+    auto addPile = [&]()
+    {
+        // Spread the piles over the dish on a fixed pattern so runs are comparable.
+        double x = 16 + (next * 37) % 224;
+        double y = 16 + (next * 101) % 224;
+        next++;
+        Dirt* pile = new (&world) Dirt(&world, x, y);
+        world.addActor(pile);
+        piles.push_back(pile);
+    };
+    for (int i = 0; i < population; i++)
+        addPile();
+
+    double totalMicros = 0;
+    long warmHeapAllocs = 0;
+    for (int t = 0; t < TICKS_PER_RUN; t++)
+    {
+        if (t == 1)
+            warmHeapAllocs = world.actorPool().stats().heapAllocations;
+
+        // Kill the oldest piles; the sweep deletes them during move().
+        for (int i = 0; i < deathsPerTick; i++)
+            piles[i]->die();
+        piles.erase(piles.begin(), piles.begin() + deathsPerTick);
+
+        auto start = chrono::steady_clock::now();
+        world.move();
+        auto end = chrono::steady_clock::now();
+        totalMicros += chrono::duration<double, micro>(end - start).count();
+
+        for (int i = 0; i < deathsPerTick; i++)
+            addPile();
+    }
+
+    heapAllocs = world.actorPool().stats().heapAllocations - warmHeapAllocs;
+    world.cleanUp();
+    return totalMicros / TICKS_PER_RUN;
+}
+
+int main()
+{
+    const int populations[] = { 1000, 10000 };
+    const int deaths[] = { 0, 16, 64, 256, 1000 };
+
+    cout << setw(10) << "actors" << setw(14) << "deaths/tick" << setw(12) << "us/tick"
+         << setw(14) << "us/death" << setw(18) << "pool heap allocs" << endl;
+    for (int population : populations)
+    {
+        long baseHeapAllocs = 0;
+        double base = runOnce(population, 0, baseHeapAllocs);
+        for (int k : deaths)
+        {
+            if (k > population) continue;
+            long heapAllocs = baseHeapAllocs;
+            double micros = (k == 0) ? base : runOnce(population, k, heapAllocs);
+            cout << setw(10) << population << setw(14) << k << setw(12) << fixed << setprecision(1) << micros;
+            if (k > 0)
+                cout << setw(14) << setprecision(3) << (micros - base) / k;
+            else
+                cout << setw(14) << "-";
+            cout << setw(18) << heapAllocs << endl;
+        }
+    }
+}
@@ -0,0 +1,147 @@
+// HeadlessMain
+// Runs the Kontagion simulation with no window, sound or GLUT, as fast as it
+// will go, feeding Socrates a scripted key sequence. Prints how many ticks
+// were simulated and how long it took.
+//
+//   Kontagion-headless [--seed N] [--levels N] [--ticks N] [--keys "left space ..."] [--script FILE]
+//                      [--profile] [--trace FILE] [--threads N]
+//
+//   --seed N      seed for the world's random number generator (default: random,
+//                 printed so the run can be repeated)
+//   --levels N    stop after N levels have been played (default 10)
+//   --ticks N     give up on a level after N ticks (default 10000, 0 = no limit)
+//   --keys TEXT   key script, one key per tick, looped (default "space none left space")
+//   --script FILE read the key script from FILE instead
+//   --profile     time each phase of move() and print the profile at the end
+//   --trace FILE  write a Chrome trace of every tick to FILE (open it in Perfetto)
+//   --threads N   update bacteria in two phases on N threads, 0 = every core
+//                 (see StudentWorld::setUpdateThreads; default 1)
+//
+// See README.md for which sources make up the headless build.
+
+#include "HeadlessController.h"
+#include "StudentWorld.h"
+#include "GameConstants.h"
+#include "Trace.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+using namespace std;
+
+static void usage()
+{
+    cout << "usage: Kontagion-headless [--seed N] [--levels N] [--ticks N] [--keys \"left space ...\"] [--script FILE] [--profile] [--trace FILE] [--threads N]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int levels = 10;
+    long maxTicks = 10000;
+    string script = "space none left space";
+    random_device rd;
+    uint64_t seed = rd();
+    bool profile = false;
+    string tracePath;
+    int threads = -1;   // leave KONTAGION_THREADS in charge
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--profile")
+        {
+            profile = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        if (arg == "--seed")
+            seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--levels")
+            levels = atoi(argv[++i]);
+        else if (arg == "--ticks")
+            maxTicks = atol(argv[++i]);
+        else if (arg == "--trace")
+            tracePath = argv[++i];
+        else if (arg == "--threads")
+            threads = atoi(argv[++i]);
+        else if (arg == "--keys")
+            script = argv[++i];
+        else if (arg == "--script")
+        {
+            ifstream ifs(argv[++i]);
+            if (!ifs)
+            {
+                cout << "Cannot open " << argv[i] << endl;
+                return 1;
+            }
+            ostringstream oss;
+            oss << ifs.rdbuf();
+            script = oss.str();
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    vector<int> keys;
+    if (!HeadlessController::parseKeyScript(script, keys))
+    {
+        cout << "Bad key script: " << script << endl;
+        return 1;
+    }
+
+    HeadlessController controller;
+    controller.setKeyScript(keys);
+    StudentWorld world("");
+    world.setController(&controller);
+    world.setSeed(seed);
+    if (profile)
+        world.tickProfiler().setEnabled(true);
+    if (threads >= 0)
+        world.setUpdateThreads(threads);
+
+    if (!tracePath.empty())
+    {
+        Trace::setThreadName("simulation");
+        Trace::setEnabled(true);
+    }
+
+    int played = 0;
+    auto start = chrono::steady_clock::now();
+    while (played < levels && !world.isGameOver() && !controller.quitRequested())
+    {
+        int status = controller.runLevel(&world, maxTicks);
+        played++;
+        if (status == GWSTATUS_PLAYER_WON || status == GWSTATUS_LEVEL_ERROR)
+            break;
+    }
+    auto end = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(end - start).count();
+    cout << "seed:          " << seed << endl;
+    cout << "levels played: " << played << endl;
+    cout << "ticks:         " << controller.ticks() << endl;
+    cout << "seconds:       " << seconds << endl;
+    cout << "ticks/second:  " << (seconds > 0 ? controller.ticks() / seconds : 0) << endl;
+    cout << "final level:   " << world.getLevel() << endl;
+    cout << "final score:   " << world.getScore() << endl;
+    cout << "lives left:    " << world.getLives() << endl;
+    if (!tracePath.empty() && !Trace::writeChromeJson(tracePath))
+        cout << "Cannot write trace to " << tracePath << endl;
+    if (profile)
+    {
+        cout << endl;
+        world.tickProfiler().dump(cout);
+    }
+}
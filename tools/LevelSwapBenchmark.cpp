@@ -0,0 +1,110 @@
+// LevelSwapBenchmark
+// Measures the wait between the player pressing Enter at a "you finished
+// the level" prompt and the first frame of the next level: the cleanUp(),
+// init() and first move() GameController runs back to back once Enter is
+// hit. Each level is timed three ways:
+//
+//   inline     nothing is prepared; cleanUp() and init() run after Enter
+//   enter-now  prepareNextLevel() is called as the prompt comes up, and
+//              Enter is pressed straight away
+//   prompted   prepareNextLevel() is called as the prompt comes up, and
+//              Enter is pressed PROMPT_MILLIS later, as a player would
+//
+//   LevelSwapBenchmark [--samples N]
+//
+// Build it against the headless simulation core (see README.md).
+
+#include "StudentWorld.h"
+#include "HeadlessController.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+const int TICKS_BEFORE_PROMPT = 300;
+const int PROMPT_MILLIS = 100;
+
+enum Mode { INLINE, ENTER_NOW, PROMPTED };
+
+// swapOnce(int level, Mode mode, int seed)
+// Plays the level before level for a while, then moves on to level the way
+// GameController does when that one is finished. Returns how long it took
+// from Enter to the end of the new level's first move(), in microseconds.
+static double swapOnce(int level, Mode mode, int seed)
+{
+    HeadlessController controller;
+    vector<int> keys;
+    HeadlessController::parseKeyScript("space none left none", keys);
+    controller.setKeyScript(keys);
+
+    StudentWorld world("");
+    world.setController(&controller);
+    world.setSeed(seed);
+    for (int l = 1; l < level - 1; l++)
+        world.advanceToNextLevel();
+    world.init();
+    for (int t = 0; t < TICKS_BEFORE_PROMPT; t++)
+    {
+        if (world.move() != GWSTATUS_CONTINUE_GAME)
+            break;
+    }
+    if (world.isGameOver())
+        world.incLives();
+
+    // The level is over and the prompt comes up.
+    world.advanceToNextLevel();
+    if (mode != INLINE)
+        world.prepareNextLevel();
+    if (mode == PROMPTED)
+        this_thread::sleep_for(chrono::milliseconds(PROMPT_MILLIS));
+
+    auto start = chrono::steady_clock::now();
+    world.cleanUp();
+    world.init();
+    world.move();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, micro>(end - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int samples = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc)
+            samples = max(1, atoi(argv[++i]));
+        else
+        {
+            cout << "usage: LevelSwapBenchmark [--samples N]" << endl;
+            return 1;
+        }
+    }
+
+    const int levels[] = { 2, 5, 10 };
+    const char* modeNames[] = { "inline", "enter-now", "prompted" };
+
+    cout << setw(7) << "level" << setw(12) << "mode" << setw(12) << "mean us"
+         << setw(11) << "p50 us" << setw(11) << "max us" << endl;
+    for (int level : levels)
+    {
+        for (int m = INLINE; m <= PROMPTED; m++)
+        {
+            vector<double> micros;
+            for (int s = 0; s < samples; s++)
+                micros.push_back(swapOnce(level, static_cast<Mode>(m), s + 1));
+            double total = 0;
+            for (double us : micros)
+                total += us;
+            sort(micros.begin(), micros.end());
+            cout << setw(7) << level << setw(12) << modeNames[m] << fixed << setprecision(1)
+                 << setw(12) << total / samples << setw(11) << micros[micros.size() / 2]
+                 << setw(11) << micros.back() << endl;
+        }
+    }
+}
@@ -0,0 +1,253 @@
+// SnapshotCheck
+// Checks StudentWorld::saveSnapshot() and restoreSnapshot() on real games.
+// For a range of seeds and levels it plays a while, then:
+//
+//   round trip  restores the snapshot into a fresh world and saves that
+//               again; the bytes have to match
+//   replay      plays the original and the restored world side by side;
+//               every tick they have to return the same status and save
+//               the same bytes
+//   corrupt     feeds in damaged snapshots -- wrong magic or version,
+//               flipped bits, truncated, with bytes added or changed and
+//               the checksum fixed up to match -- each of which has to be
+//               turned down without touching the level in progress, or
+//               (for changes that still make a level) be playable
+//   timing      reports the mean save and restore time and snapshot size;
+//               restoring has to stay well under a millisecond
+//
+//   SnapshotCheck [--seeds N] [--levels N] [--ticks N]
+//
+// Exits with status 1 if any check fails. Build it against the headless
+// simulation core (see README.md).
+
+#include "StudentWorld.h"
+#include "WorldController.h"
+#include "Snapshot.h"
+#include "RandomGenerator.h"
+#include "GameConstants.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+using namespace std;
+
+const double RESTORE_LIMIT_MICROS = 1000;
+const int REPLAY_TICKS = 300;
+const int CORRUPTIONS_PER_SNAPSHOT = 40;
+
+// TickKeys
+// Presses keys by the world's tick rather than by how many times it has been
+// asked, so a world restored at tick t gets the same keys from then on as
+// the one it was saved from.
+class TickKeys : public WorldController
+{
+  public:
+    explicit TickKeys(const StudentWorld& world) : m_world(world) {}
+
+    virtual bool getLastKey(int& value)
+    {
+        static const int keys[] = { KEY_PRESS_LEFT, KEY_PRESS_SPACE, 0, KEY_PRESS_RIGHT,
+                                    KEY_PRESS_SPACE, 0, 0, KEY_PRESS_ENTER };
+        int key = keys[m_world.getTick() % (sizeof(keys) / sizeof(keys[0]))];
+        if (key == 0)
+            return false;
+        value = key;
+        return true;
+    }
+
+    virtual void playSound(int /* soundID */) {}
+    virtual void setGameStatText(const char* /* text */) {}
+    virtual void quitGame() {}
+
+  private:
+    const StudentWorld& m_world;
+};
+
+struct Totals
+{
+    int snapshots = 0;
+    int failures = 0;
+    int rejected = 0;
+    int acceptedChanges = 0;
+    double saveMicros = 0;
+    double restoreMicros = 0;
+    size_t bytes = 0;
+};
+
+static void fail(Totals& totals, const string& what, long seed, int level)
+{
+    cout << "FAIL " << what << " (seed " << seed << ", level " << level << ")" << endl;
+    totals.failures++;
+}
+
+static void fixChecksum(vector<uint8_t>& snap)
+{
+    const size_t CHECKSUM_SIZE = 8;
+    if (snap.size() < CHECKSUM_SIZE)
+        return;
+    snap.resize(snap.size() - CHECKSUM_SIZE);
+    uint64_t checksum = snapshotChecksum(snap.data(), snap.size());
+    SnapshotWriter(snap).writeUInt64(checksum);
+}
+
+// corrupt(const vector<uint8_t>& good, int k, RandomGenerator& rng)
+// Returns the k-th damaged copy of good.
+static vector<uint8_t> corrupt(const vector<uint8_t>& good, int k, RandomGenerator& rng)
+{
+    vector<uint8_t> bad = good;
+    int at = rng.randInt(0, static_cast<int>(good.size()) - 1);
+    switch (k % 8)
+    {
+        case 0: bad[0] = 'X'; break;                                    // magic
+        case 1: bad[4] ^= 0x7E; fixChecksum(bad); break;                // version
+        case 2: bad[at] ^= 1 << rng.randInt(0, 7); break;               // checksum catches it
+        case 3: bad.resize(at); break;                                  // truncated
+        case 4: bad.resize(at); fixChecksum(bad); break;                // cut short, checksum fixed
+        case 5: bad.insert(bad.end() - 8, 0); fixChecksum(bad); break;  // a byte too many
+        case 6: bad[min(at, static_cast<int>(bad.size()) - 9)] ^= 1 << rng.randInt(0, 7); fixChecksum(bad); break;
+        case 7: bad[min(at, static_cast<int>(bad.size()) - 9)] = 0xFF; fixChecksum(bad); break;
+    }
+    return bad;
+}
+
+static void checkSnapshot(StudentWorld& original, long seed, int level, Totals& totals)
+{
+    vector<uint8_t> snap;
+    auto saveStart = chrono::steady_clock::now();
+    bool saved = original.saveSnapshot(snap);
+    auto saveEnd = chrono::steady_clock::now();
+    if (!saved)
+    {
+        fail(totals, "save", seed, level);
+        return;
+    }
+
+    StudentWorld restored("");
+    TickKeys restoredKeys(restored);
+    restored.setController(&restoredKeys);
+    auto restoreStart = chrono::steady_clock::now();
+    bool ok = restored.restoreSnapshot(snap);
+    auto restoreEnd = chrono::steady_clock::now();
+    totals.snapshots++;
+    totals.bytes += snap.size();
+    totals.saveMicros += chrono::duration<double, micro>(saveEnd - saveStart).count();
+    totals.restoreMicros += chrono::duration<double, micro>(restoreEnd - restoreStart).count();
+
+    // Round trip.
+    vector<uint8_t> again;
+    if (!ok || !restored.saveSnapshot(again) || again != snap)
+    {
+        fail(totals, "round trip", seed, level);
+        return;
+    }
+
+    // Damaged copies are checked against the restored world, which has to
+    // come out of each rejection exactly as it went in.
+    RandomGenerator rng(seed * 1000 + level);
+    for (int k = 0; k < CORRUPTIONS_PER_SNAPSHOT; k++)
+    {
+        vector<uint8_t> before;
+        restored.saveSnapshot(before);
+        if (restored.restoreSnapshot(corrupt(snap, k, rng)))
+        {
+            // Still a level, just not the same one: it has to play.
+            totals.acceptedChanges++;
+            for (int t = 0; t < 10; t++)
+            {
+                if (restored.move() != GWSTATUS_CONTINUE_GAME)
+                    break;
+            }
+        }
+        else
+        {
+            totals.rejected++;
+            vector<uint8_t> after;
+            if (!restored.saveSnapshot(after) || after != before)
+                fail(totals, "rejected snapshot changed the world", seed, level);
+        }
+        restored.restoreSnapshot(snap);
+    }
+
+    // Side by side.
+    for (int t = 0; t < REPLAY_TICKS; t++)
+    {
+        int a = original.move();
+        int b = restored.move();
+        vector<uint8_t> snapA, snapB;
+        original.saveSnapshot(snapA);
+        restored.saveSnapshot(snapB);
+        if (a != b || snapA != snapB)
+        {
+            fail(totals, "replay diverged at tick " + to_string(t), seed, level);
+            return;
+        }
+        if (a != GWSTATUS_CONTINUE_GAME)
+            return;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int seeds = 6, levels = 8, ticks = 200;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 < argc && arg == "--seeds")
+            seeds = max(1, atoi(argv[++i]));
+        else if (i + 1 < argc && arg == "--levels")
+            levels = max(1, atoi(argv[++i]));
+        else if (i + 1 < argc && arg == "--ticks")
+            ticks = max(0, atoi(argv[++i]));
+        else
+        {
+            cout << "usage: SnapshotCheck [--seeds N] [--levels N] [--ticks N]" << endl;
+            return 1;
+        }
+    }
+
+    Totals totals;
+    for (long seed = 1; seed <= seeds; seed++)
+    {
+        for (int level = 1; level <= levels; level++)
+        {
+            StudentWorld world("");
+            TickKeys keys(world);
+            world.setController(&keys);
+            world.setSeed(seed);
+            for (int l = 1; l < level; l++)
+                world.advanceToNextLevel();
+            world.init();
+
+            // Save right after init() and again partway through the level.
+            checkSnapshot(world, seed, level, totals);
+            world.cleanUp();
+            world.init();
+            int status = GWSTATUS_CONTINUE_GAME;
+            for (int t = 0; t < ticks && status == GWSTATUS_CONTINUE_GAME; t++)
+                status = world.move();
+            if (status == GWSTATUS_CONTINUE_GAME)
+                checkSnapshot(world, seed, level, totals);
+            world.cleanUp();
+        }
+    }
+
+    double meanRestore = totals.snapshots > 0 ? totals.restoreMicros / totals.snapshots : 0;
+    cout << "snapshots:        " << totals.snapshots << endl;
+    cout << "mean size:        " << (totals.snapshots > 0 ? totals.bytes / totals.snapshots : 0) << " bytes" << endl;
+    cout << fixed << setprecision(1);
+    cout << "mean save:        " << (totals.snapshots > 0 ? totals.saveMicros / totals.snapshots : 0) << " us" << endl;
+    cout << "mean restore:     " << meanRestore << " us" << endl;
+    cout << "corrupt rejected: " << totals.rejected << endl;
+    cout << "changed, played:  " << totals.acceptedChanges << endl;
+    if (meanRestore >= RESTORE_LIMIT_MICROS)
+    {
+        cout << "FAIL restoring takes " << meanRestore << " us" << endl;
+        totals.failures++;
+    }
+    cout << "failures:         " << totals.failures << endl;
+    return totals.failures > 0 ? 1 : 0;
+}
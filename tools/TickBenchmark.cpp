@@ -0,0 +1,424 @@
+// TickBenchmark
+// Tick-throughput benchmark for StudentWorld::move(). Builds a set of worlds
+// directly -- real levels, dishes packed with bacteria or dirt, and a dish
+// under constant spray and flame fire -- and for each one measures ticks per
+// second, p50/p99 tick latency and heap allocations per tick.
+//
+//   TickBenchmark [--json FILE] [--baseline FILE] [--tolerance PCT]
+//                 [--scale F] [--only NAME] [--profile] [--threads N]
+//                 [--scaling]
+//
+//   --json FILE      also write the results to FILE as JSON
+//   --baseline FILE  compare against results from an earlier --json run and
+//                    exit with status 1 if any scenario got slower
+//   --tolerance PCT  how much slower (ticks/s or p99) counts as a regression
+//                    (default 10)
+//   --scale F        multiply every scenario's tick count by F (default 1)
+//   --only NAME      run just the named scenario
+//   --profile        also print each scenario's phase and per-class costs
+//                    (see TickProfiler.h); the timings then include its overhead
+//   --threads N      update bacteria in two phases on N threads, 0 = every
+//                    core (see StudentWorld::setUpdateThreads; default 1)
+//   --scaling        instead, run the bacteria scenarios on 1, 2, 4, ...
+//                    threads up to one per core and report each one's
+//                    speedup over the one-thread update
+//
+// Build it against the headless simulation core (see README.md).
+
+#include "Actor.h"
+#include "StudentWorld.h"
+#include "HeadlessController.h"
+#include "RandomGenerator.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <thread>
+using namespace std;
+
+// Every heap allocation made by this program goes through here, so the
+// benchmark can tell how many happen inside move(), on any thread.
+static atomic<long> g_heapAllocations(0);
+
+void* operator new(size_t size)
+{
+    g_heapAllocations++;
+    if (void* p = malloc(size == 0 ? 1 : size))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+const int WARMUP_TICKS = 10;
+
+struct Scenario
+{
+    string name;
+    int level;              // level to init() the world at
+    int extraBacteria;      // added on top of what the level spawns
+    int extraDirt;
+    bool volleys;           // fire a spray and a ring of flames every tick
+    string keys;            // Socrates' key script
+    long ticks;             // measured ticks
+};
+
+struct Result
+{
+    string name;
+    int threads;            // what the world actually updated on
+    long ticks;
+    double ticksPerSecond;
+    double p50Micros;
+    double p99Micros;
+    double allocsPerTick;
+    double meanActors;
+};
+
+// randomDishPosition(RandomGenerator& rng, double& x, double& y)
+// Picks a point at most 120 pixels from the centre of the dish.
+static void randomDishPosition(RandomGenerator& rng, double& x, double& y)
+{
+    do
+    {
+        x = rng.randInt(VIEW_RADIUS - 120, VIEW_RADIUS + 120);
+        y = rng.randInt(VIEW_RADIUS - 120, VIEW_RADIUS + 120);
+    } while ((x - VIEW_RADIUS) * (x - VIEW_RADIUS) + (y - VIEW_RADIUS) * (y - VIEW_RADIUS) > 120 * 120);
+}
+
+// populate(StudentWorld& world, const Scenario& s, RandomGenerator& rng)
+// Adds the scenario's extra bacteria and dirt on top of the level's own layout.
+static void populate(StudentWorld& world, const Scenario& s, RandomGenerator& rng)
+{
+    double x = 0, y = 0;
+    for (int i = 0; i < s.extraDirt; i++)
+    {
+        randomDishPosition(rng, x, y);
+        world.addActor(new (&world) Dirt(&world, x, y));
+    }
+    for (int i = 0; i < s.extraBacteria; i++)
+    {
+        randomDishPosition(rng, x, y);
+        switch (i % 3)
+        {
+            case 0:  world.addActor(new (&world) RegularSalmonella(&world, x, y)); break;
+            case 1:  world.addActor(new (&world) AggressiveSalmonella(&world, x, y)); break;
+            default: world.addActor(new (&world) EColi(&world, x, y)); break;
+        }
+    }
+}
+
+// fireVolley(StudentWorld& world, long tick)
+// One spray and a ring of 16 flames from a point that walks around the rim,
+// the same pattern Socrates fires.
+static void fireVolley(StudentWorld& world, long tick)
+{
+    const double PI = 4 * atan(1);
+    int rimAngle = static_cast<int>((tick * 5) % 360);
+    double x = VIEW_RADIUS + VIEW_RADIUS * cos(rimAngle * PI / 180);
+    double y = VIEW_RADIUS + VIEW_RADIUS * sin(rimAngle * PI / 180);
+    world.addActor(new (&world) DisinfectantSpray(&world, x, y, (rimAngle + 180) % 360));
+    for (int i = 0; i < 16; i++)
+        world.addActor(new (&world) Flame(&world, x, y, 22 * i));
+}
+
+static Result runScenario(const Scenario& s, bool profile, int threads)
+{
+    HeadlessController controller;
+    vector<int> keys;
+    HeadlessController::parseKeyScript(s.keys, keys);
+    controller.setKeyScript(keys);
+
+    StudentWorld world("");
+    world.setController(&controller);
+    world.setSeed(20240101);
+    world.tickProfiler().setEnabled(profile);
+    world.setUpdateThreads(threads);
+    for (int l = 1; l < s.level; l++)
+        world.advanceToNextLevel();
+
+    RandomGenerator rng(7);
+    world.init();
+    populate(world, s, rng);
+
+    vector<double> micros;
+    micros.reserve(s.ticks);
+    long allocations = 0;
+    double actorSamples = 0;
+
+    for (long t = 0; t < WARMUP_TICKS + s.ticks; t++)
+    {
+        if (s.volleys)
+            fireVolley(world, t);
+
+        long allocsBefore = g_heapAllocations;
+        auto start = chrono::steady_clock::now();
+        int status = world.move();
+        auto end = chrono::steady_clock::now();
+
+        if (t >= WARMUP_TICKS)
+        {
+            micros.push_back(chrono::duration<double, micro>(end - start).count());
+            allocations += g_heapAllocations - allocsBefore;
+            actorSamples += world.getNumBacteria();
+        }
+
+        // Keep the scenario going if the level ends early; rebuilding the
+        // world isn't part of what's being measured.
+        if (status != GWSTATUS_CONTINUE_GAME)
+        {
+            world.cleanUp();
+            if (world.isGameOver())
+                world.incLives();
+            world.init();
+            populate(world, s, rng);
+        }
+    }
+    int usedThreads = world.getUpdateThreads();
+    world.cleanUp();
+    if (profile)
+        world.tickProfiler().dump(cout);
+
+    Result r;
+    r.name = s.name;
+    r.threads = usedThreads;
+    r.ticks = s.ticks;
+    double total = 0;
+    for (double m : micros)
+        total += m;
+    sort(micros.begin(), micros.end());
+    r.ticksPerSecond = total > 0 ? s.ticks / (total / 1e6) : 0;
+    r.p50Micros = micros[micros.size() / 2];
+    r.p99Micros = micros[min(micros.size() - 1, micros.size() * 99 / 100)];
+    r.allocsPerTick = double(allocations) / s.ticks;
+    r.meanActors = actorSamples / s.ticks;
+    return r;
+}
+
+static void writeJson(ostream& out, const vector<Result>& results)
+{
+    out << "{\n  \"benchmark\": \"kontagion-tick\",\n  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ticks\": " << r.ticks
+            << ", \"ticks_per_second\": " << r.ticksPerSecond
+            << ", \"p50_us\": " << r.p50Micros << ", \"p99_us\": " << r.p99Micros
+            << ", \"allocs_per_tick\": " << r.allocsPerTick
+            << ", \"mean_bacteria\": " << r.meanActors << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// jsonNumber(const string& line, const string& key, double& value)
+// Pulls "key": number out of one scenario line written by writeJson().
+static bool jsonNumber(const string& line, const string& key, double& value)
+{
+    size_t pos = line.find("\"" + key + "\":");
+    if (pos == string::npos)
+        return false;
+    value = atof(line.c_str() + pos + key.size() + 3);
+    return true;
+}
+
+// readBaseline(string path, map<string, Result>& baseline)
+// Reads a file written by --json. Only understands that layout: one
+// scenario object per line.
+static bool readBaseline(string path, map<string, Result>& baseline)
+{
+    ifstream ifs(path);
+    if (!ifs)
+        return false;
+    string line;
+    while (getline(ifs, line))
+    {
+        size_t pos = line.find("\"name\": \"");
+        if (pos == string::npos)
+            continue;
+        pos += 9;
+        Result r;
+        r.name = line.substr(pos, line.find('"', pos) - pos);
+        if (!jsonNumber(line, "ticks_per_second", r.ticksPerSecond) ||
+            !jsonNumber(line, "p99_us", r.p99Micros))
+            continue;
+        jsonNumber(line, "p50_us", r.p50Micros);
+        jsonNumber(line, "allocs_per_tick", r.allocsPerTick);
+        baseline[r.name] = r;
+    }
+    return true;
+}
+
+static void usage()
+{
+    cout << "usage: TickBenchmark [--json FILE] [--baseline FILE] [--tolerance PCT] [--scale F] [--only NAME] [--profile] [--threads N] [--scaling]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    string jsonPath, baselinePath, only;
+    double tolerance = 10;
+    double scale = 1;
+    bool profile = false;
+    bool scaling = false;
+    int threads = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--profile")
+        {
+            profile = true;
+            continue;
+        }
+        if (arg == "--scaling")
+        {
+            scaling = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        if (arg == "--json")
+            jsonPath = argv[++i];
+        else if (arg == "--baseline")
+            baselinePath = argv[++i];
+        else if (arg == "--tolerance")
+            tolerance = atof(argv[++i]);
+        else if (arg == "--scale")
+            scale = atof(argv[++i]);
+        else if (arg == "--only")
+            only = argv[++i];
+        else if (arg == "--threads")
+            threads = atoi(argv[++i]);
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    const string play = "space none left none space right none enter";
+    const Scenario scenarios[] = {
+        // name               level  bacteria  dirt  volleys  keys    ticks
+        { "level1",              1,        0,     0, false,   play,   3000 },
+        { "level10",            10,        0,     0, false,   play,   3000 },
+        { "bacteria1k",          1,     1000,     0, false,   "none", 300 },
+        { "bacteria10k",         1,    10000,     0, false,   "none", 60 },
+        { "bacteria100k",        1,   100000,     0, false,   "none", 10 },
+        { "dirt-saturated",      1,      200,  3000, false,   play,   500 },
+        { "spray-and-flame",     5,      500,     0, true,    "none", 500 },
+    };
+
+    vector<Result> results;
+    if (scaling)
+    {
+        // Thread counts to try: doubling from one up to every core, and
+        // every core itself if that isn't a power of two.
+        int cores = max(1, static_cast<int>(thread::hardware_concurrency()));
+        vector<int> counts;
+        for (int t = 1; t < cores; t *= 2)
+            counts.push_back(t);
+        counts.push_back(cores);
+
+        cout << "cores: " << cores << endl;
+        cout << setw(18) << left << "scenario" << right << setw(9) << "threads" << setw(8) << "ticks"
+             << setw(14) << "ticks/s" << setw(11) << "p50 us" << setw(11) << "p99 us"
+             << setw(10) << "speedup" << endl;
+        for (Scenario s : scenarios)
+        {
+            if (only.empty() ? s.extraBacteria < 1000 : s.name != only)
+                continue;
+            s.ticks = max(1L, static_cast<long>(s.ticks * scale));
+            double oneThread = 0;
+            for (int t : counts)
+            {
+                Result r = runScenario(s, profile, t);
+                if (t == 1)
+                    oneThread = r.ticksPerSecond;
+                r.name = s.name + "/" + to_string(t) + "t";
+                results.push_back(r);
+                cout << setw(18) << left << s.name << right << setw(9) << r.threads << setw(8) << r.ticks
+                     << fixed << setprecision(1) << setw(14) << r.ticksPerSecond << setw(11) << r.p50Micros
+                     << setw(11) << r.p99Micros << setw(9) << setprecision(2)
+                     << (oneThread > 0 ? r.ticksPerSecond / oneThread : 0) << "x" << endl;
+            }
+        }
+    }
+    else
+    {
+        cout << setw(18) << left << "scenario" << right << setw(8) << "ticks" << setw(14) << "ticks/s"
+             << setw(11) << "p50 us" << setw(11) << "p99 us" << setw(13) << "allocs/tick"
+             << setw(11) << "bacteria" << endl;
+        for (Scenario s : scenarios)
+        {
+            if (!only.empty() && s.name != only)
+                continue;
+            s.ticks = max(1L, static_cast<long>(s.ticks * scale));
+            Result r = runScenario(s, profile, threads);
+            results.push_back(r);
+            cout << setw(18) << left << r.name << right << setw(8) << r.ticks << fixed << setprecision(1)
+                 << setw(14) << r.ticksPerSecond << setw(11) << r.p50Micros << setw(11) << r.p99Micros
+                 << setw(13) << setprecision(2) << r.allocsPerTick << setw(11) << setprecision(0) << r.meanActors << endl;
+        }
+    }
+
+    if (!jsonPath.empty())
+    {
+        ofstream ofs(jsonPath);
+        if (!ofs)
+        {
+            cout << "Cannot write " << jsonPath << endl;
+            return 1;
+        }
+        writeJson(ofs, results);
+    }
+
+    if (!baselinePath.empty())
+    {
+        map<string, Result> baseline;
+        if (!readBaseline(baselinePath, baseline))
+        {
+            cout << "Cannot read " << baselinePath << endl;
+            return 1;
+        }
+        bool regressed = false;
+        cout << endl << setw(18) << left << "vs baseline" << right << setw(14) << "ticks/s" << setw(11) << "p99" << endl;
+        for (const Result& r : results)
+        {
+            auto it = baseline.find(r.name);
+            if (it == baseline.end())
+            {
+                cout << setw(18) << left << r.name << right << "  (not in baseline)" << endl;
+                continue;
+            }
+            double speed = (r.ticksPerSecond / it->second.ticksPerSecond - 1) * 100;
+            double p99 = (r.p99Micros / it->second.p99Micros - 1) * 100;
+            bool bad = speed < -tolerance || p99 > tolerance;
+            regressed = regressed || bad;
+            cout << setw(18) << left << r.name << right << showpos << fixed << setprecision(1)
+                 << setw(13) << speed << "%" << setw(10) << p99 << "%" << noshowpos
+                 << (bad ? "  REGRESSION" : "") << endl;
+        }
+        if (regressed)
+            return 1;
+    }
+}